@@ -0,0 +1,513 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cstdlib>
+#include <climits>
+#include <limits>
+#include <algorithm>
+#include <marklang.h>
+
+// Builds scripts through the public API and checks what they return. Exits with the number of failed checks
+static int failures = 0;
+
+static void Check(bool ok, const char *test, int line) {
+	if (ok) return;
+
+	std::cerr << test << " " << line << " Check failed\n";
+	failures++;
+}
+
+// Built and run module, null if any step failed
+static mlang::Module *BuildModule(mlang::Engine &engine, const std::string &name, const std::string &source) {
+	if (engine.NewModule(name) != mlang::RespCode::SUCCESS) return nullptr;
+
+	auto mod = engine.GetModule(name).data.value();
+	if (mod->AddSectionFromMemory(source) != mlang::RespCode::SUCCESS || mod->Build() != mlang::RespCode::SUCCESS || mod->Run() != mlang::RespCode::SUCCESS) {
+		return nullptr;
+	}
+	return mod;
+}
+
+template<typename Signature, typename... Args>
+static auto Call(mlang::Module *mod, const std::string &name, Args... args) {
+	return mod->GetFunction<Signature>(name).data.value()(args...);
+}
+
+static void TestCalls() {
+	mlang::Engine engine;
+	auto mod = BuildModule(engine, "calls", R"(
+class Point{
+	int x;
+	int y;
+	public:
+	void Set(int a, int b) { x = a; y = b; }
+	int Sum() { return x + y; }
+};
+Point point;
+int fib(int n) { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); }
+int sumTo(int n) { int s = 0; for (int i = 0; i < n; i = i + 1) { s = s + i; } return s; }
+int firstSquareOver(int n) { int i = 0; while (i >= 0) { if (i * i > n) { break; } i = i + 1; } return i; }
+int points() { point.Set(3; 4); return point.Sum(); }
+long forever(long n) { return forever(n + 1); }
+int main(){ return 0; }
+)");
+	Check(mod, __func__, __LINE__);
+	if (!mod) return;
+
+	Check(Call<int(int)>(mod, "fib", 20).data.value() == 6765, __func__, __LINE__);
+	Check(Call<int(int)>(mod, "sumTo", 100).data.value() == 4950, __func__, __LINE__);
+	Check(Call<int(int)>(mod, "firstSquareOver", 50).data.value() == 8, __func__, __LINE__);
+	Check(Call<int()>(mod, "points").data.value() == 7, __func__, __LINE__);
+
+	// Runaway recursion fails the call instead of the host
+	Check(Call<int64_t(int64_t)>(mod, "forever", int64_t(0)).code != mlang::RespCode::SUCCESS, __func__, __LINE__);
+	Check(Call<int(int)>(mod, "fib", 10).data.value() == 55, __func__, __LINE__);
+}
+
+static void TestArithmetic() {
+	mlang::Engine engine;
+	auto mod = BuildModule(engine, "arith", R"(
+int wrap(int x) { return x + 1; }
+char narrow(int x) { char c = x * 20; return c; }
+double mixed(int x, float f) { return x * f + x / 2; }
+bool less(double a, long b) { return a < b; }
+int main(){ return 0; }
+)");
+	Check(mod, __func__, __LINE__);
+	if (!mod) return;
+
+	Check(Call<int(int)>(mod, "wrap", INT_MAX).data.value() == INT_MIN, __func__, __LINE__);
+	Check(Call<int(int)>(mod, "narrow", 10).data.value() == static_cast<char>(200), __func__, __LINE__);
+	Check(Call<double(int, float)>(mod, "mixed", 3, 0.5f).data.value() == 2.5, __func__, __LINE__);
+	Check(Call<bool(double, int64_t)>(mod, "less", 2.5, int64_t(3)).data.value(), __func__, __LINE__);
+}
+
+static void TestDivision() {
+	mlang::Engine engine;
+	auto mod = BuildModule(engine, "div", R"(
+int div(int a, int b) { return a / b; }
+long ldiv(long a, long b) { return a / b; }
+double fdiv(double a, int b) { return a / b; }
+int main(){ return 0; }
+)");
+	Check(mod, __func__, __LINE__);
+	if (!mod) return;
+
+	Check(Call<int(int, int)>(mod, "div", 7, 2).data.value() == 3, __func__, __LINE__);
+	Check(Call<int(int, int)>(mod, "div", -7, 2).data.value() == -3, __func__, __LINE__);
+	// The smallest value divided by -1 wraps around to itself
+	Check(Call<int(int, int)>(mod, "div", INT_MIN, -1).data.value() == INT_MIN, __func__, __LINE__);
+	Check(Call<int64_t(int64_t, int64_t)>(mod, "ldiv", INT64_MIN, int64_t(-1)).data.value() == INT64_MIN, __func__, __LINE__);
+	Check(Call<double(double, int)>(mod, "fdiv", 1.0, 0).data.value() == std::numeric_limits<double>::infinity(), __func__, __LINE__);
+
+	bool threw = false;
+	try {
+		Call<int(int, int)>(mod, "div", 1, 0);
+	}
+	catch (const std::exception &) {
+		threw = true;
+	}
+	Check(threw, __func__, __LINE__);
+}
+
+static int64_t Twice(int64_t x) { return x * 2; }
+
+static void TestNative() {
+	mlang::Engine engine;
+	int64_t counter = 0;
+	Check(engine.RegisterFunction("twice", &Twice) == mlang::RespCode::SUCCESS, __func__, __LINE__);
+	Check(engine.RegisterFunction("bump", [&counter](int64_t by, char c, double d) { counter += by + c + static_cast<int64_t>(d * 2); }) == mlang::RespCode::SUCCESS, __func__, __LINE__);
+	Check(engine.RegisterFunction("seven", []() { return 7; }) == mlang::RespCode::SUCCESS, __func__, __LINE__);
+	Check(engine.RegisterFunction("half", [](double v) { return v / 2; }) == mlang::RespCode::SUCCESS, __func__, __LINE__);
+	// Names are taken once
+	Check(engine.RegisterFunction("seven", []() { return 8; }) != mlang::RespCode::SUCCESS, __func__, __LINE__);
+
+	auto mod = BuildModule(engine, "native", R"(
+long run() { bump(twice(3); 2; 0.5); bump(seven(); 0; 0); return twice(seven()); }
+double halved() { return half(seven()); }
+long many(int n) { long t = 0; int i = 0; while (i < n) { t = t + twice(i); i = i + 1; } return t; }
+int main(){ return 0; }
+)");
+	Check(mod, __func__, __LINE__);
+	if (!mod) return;
+
+	Check(Call<int64_t()>(mod, "run").data.value() == 14, __func__, __LINE__);
+	Check(counter == 6 + 2 + 1 + 7, __func__, __LINE__);
+	Check(Call<double()>(mod, "halved").data.value() == 3.5, __func__, __LINE__);
+	// Called from a loop hot enough to run in the optimized tiers
+	Check(Call<int64_t(int)>(mod, "many", 20000).data.value() == int64_t(19999) * 20000, __func__, __LINE__);
+}
+
+// Every context sees its own copy of other modules' objects
+static void TestContexts() {
+	mlang::Engine engine;
+	auto lib = BuildModule(engine, "lib", "long counter = 100;\nlong bump(int x) { counter = counter + x; return counter; }\nint main(){ return 0; }\n");
+	auto mod = BuildModule(engine, "app", "long add(int x) { bump(x); return counter; }\nint main(){ return 0; }\n");
+	Check(lib && mod, __func__, __LINE__);
+	if (!lib || !mod) return;
+
+	std::vector<int64_t> results(4);
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; ++t) {
+		threads.emplace_back([&results, mod, t] {
+			auto context = mod->CreateContext();
+			context->Initialize();
+
+			auto add = mod->GetFunction<int64_t(int)>("add", context.get()).data.value();
+			for (int i = 0; i < 1000; ++i) results[t] = add(t + 1).data.value();
+		});
+	}
+	for (auto &thread : threads) thread.join();
+
+	for (int t = 0; t < 4; ++t) Check(results[t] == 100 + 1000 * (t + 1), __func__, __LINE__);
+	// The module's own context is left untouched
+	Check(Call<int64_t(int)>(lib, "bump", 0).data.value() == 100, __func__, __LINE__);
+}
+
+// A module that fails to compile takes its declarations back, the modules after it can declare the same names
+static void TestBuildModules() {
+	mlang::Engine engine;
+	std::vector<std::pair<std::string, std::string>> sources = {
+		{ "lib", "int base = 10;\nint scaled(int x) { return x * base; }\nint main(){ return 0; }\n" },
+		{ "broken", "class C{ public: int v; };\nint shared = 3;\nvoid bad() { return 1; }\nint main(){ return 0; }\n" },
+		{ "app", "class C{ public: int v; };\nint shared = 4;\nint f() { C c; c.v = scaled(shared); return c.v; }\nint main(){ return f(); }\n" }
+	};
+	std::vector<std::string> names;
+	for (auto &[name, source] : sources) {
+		engine.NewModule(name);
+		engine.GetModule(name).data.value()->AddSectionFromMemory(source);
+		names.push_back(name);
+	}
+
+	Check(engine.BuildModules(names, 2) != mlang::RespCode::SUCCESS, __func__, __LINE__);
+
+	auto app = engine.GetModule("app").data.value();
+	Check(app->Run() == mlang::RespCode::SUCCESS, __func__, __LINE__);
+	Check(Call<int()>(app, "f").data.value() == 40, __func__, __LINE__);
+}
+
+static std::string TempPath(const std::string &name) {
+	return (std::filesystem::temp_directory_path() / name).string();
+}
+static std::string ReadFile(const std::string &file) {
+	std::ifstream in(file, std::ios::binary);
+	return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+static void WriteFile(const std::string &file, const std::string &bytes) {
+	std::ofstream(file, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size());
+}
+
+static void TestSaveLoad() {
+	static const char *source = R"(
+class Acc{
+	int total;
+	public:
+	int Add(int x) { total = total + x; return total; }
+};
+int base = 10;
+Acc acc;
+double scale(int x, float f) { return x * f + base; }
+int bump(int x) { return acc.Add(x) * 2 + base; }
+int main(){ int i = 0; while (i < 3) { i = i + 1; } return bump(i); }
+)";
+	auto file = TempPath("mlang_tests.mlc");
+
+	// main already added 3
+	{
+		mlang::Engine engine;
+		auto mod = BuildModule(engine, "saved", source);
+		Check(mod && mod->SaveCompiled(file) == mlang::RespCode::SUCCESS, __func__, __LINE__);
+		if (mod) Check(Call<int(int)>(mod, "bump", 4).data.value() == 24, __func__, __LINE__);
+	}
+
+	{
+		mlang::Engine engine;
+		engine.NewModule("saved");
+		auto mod = engine.GetModule("saved").data.value();
+		mod->AddSectionFromMemory(source);
+		Check(mod->LoadCompiled(file) == mlang::RespCode::SUCCESS, __func__, __LINE__);
+		Check(mod->Run() == mlang::RespCode::SUCCESS, __func__, __LINE__);
+
+		Check(Call<double(int, float)>(mod, "scale", 3, 0.5f).data.value() == 11.5, __func__, __LINE__);
+		Check(Call<int(int)>(mod, "bump", 4).data.value() == 24, __func__, __LINE__);
+		Check(Call<int(int)>(mod, "bump", 1).data.value() == 26, __func__, __LINE__);
+	}
+
+	// Truncated files are rejected
+	auto bytes = ReadFile(file);
+	for (size_t size : { bytes.size() / 2, bytes.size() - 1 }) {
+		WriteFile(file, bytes.substr(0, size));
+
+		mlang::Engine engine;
+		engine.NewModule("saved");
+		auto mod = engine.GetModule("saved").data.value();
+		mod->AddSectionFromMemory(source);
+		Check(mod->LoadCompiled(file) != mlang::RespCode::SUCCESS, __func__, __LINE__);
+	}
+	std::filesystem::remove(file);
+}
+
+// Files edited to call a method without its object, or on an object of another class, are rejected
+static void TestHostileFiles() {
+	auto file = TempPath("mlang_tests_hostile.mlc");
+
+	// Get has a loop so it isn't inlined into Twice
+	static const char *boxSource = R"(
+class Box{
+	int v;
+	public:
+	int Get() { int i = 0; while (i < 1) { i = i + 1; } return v + i; }
+	int Twice() { return Get() * 2; }
+};
+Box box;
+int run() { return box.Twice(); }
+int main(){ return 0; }
+)";
+	{
+		mlang::Engine engine;
+		auto mod = BuildModule(engine, "box", boxSource);
+		Check(mod && mod->SaveCompiled(file) == mlang::RespCode::SUCCESS, __func__, __LINE__);
+	}
+
+	// Get's binding in Twice: a method reached through this, at offset 0
+	auto bytes = ReadFile(file);
+	std::vector<size_t> found;
+	for (size_t i = 0; i + 12 <= bytes.size(); ++i) {
+		if (bytes[i] == static_cast<char>(mlang::Binding::Kind::METHOD) && bytes[i + 1] == static_cast<char>(mlang::Binding::Base::THIS) &&
+			static_cast<unsigned char>(bytes[i + 2]) <= 1 && static_cast<unsigned char>(bytes[i + 3]) <= 1 && bytes.compare(i + 4, 8, std::string(8, '\0')) == 0) {
+			found.push_back(i);
+		}
+	}
+	Check(found.size() == 1, __func__, __LINE__);
+	if (found.size() == 1) {
+		bytes[found[0]] = static_cast<char>(mlang::Binding::Kind::FUNCTION);
+		WriteFile(file, bytes);
+
+		mlang::Engine engine;
+		engine.NewModule("box");
+		auto mod = engine.GetModule("box").data.value();
+		mod->AddSectionFromMemory(boxSource);
+		Check(mod->LoadCompiled(file) != mlang::RespCode::SUCCESS, __func__, __LINE__);
+	}
+
+	static const char *shapesSource = R"(
+class Small{
+	int a;
+	public:
+	int Get() { int i = 0; while (i < 1) { i = i + 1; } return a; }
+};
+class Large{
+	int a;
+	int b;
+	int c;
+	int d;
+	public:
+	int Get() { int i = 0; while (i < 1) { i = i + 1; } return d; }
+};
+Small small;
+int main(){ return 0; }
+)";
+	static const char *userSource = "int run() { return small.Get(); }\nint main(){ return 0; }\n";
+	{
+		mlang::Engine engine;
+		auto shapes = BuildModule(engine, "shapes", shapesSource);
+		auto user = BuildModule(engine, "user", userSource);
+		Check(shapes && user && user->SaveCompiled(file) == mlang::RespCode::SUCCESS, __func__, __LINE__);
+	}
+
+	// Methods of other modules are saved by class and method name
+	bytes = ReadFile(file);
+	found.clear();
+	for (size_t i = 0; (i = bytes.find("Small", i)) != std::string::npos; ++i) {
+		if (bytes.find("Get", i + 5) <= i + 12) found.push_back(i);
+	}
+	Check(found.size() == 1, __func__, __LINE__);
+
+	auto load = [&](const std::string &bytes) {
+		WriteFile(file, bytes);
+
+		mlang::Engine engine;
+		BuildModule(engine, "shapes", shapesSource);
+		engine.NewModule("user");
+		auto user = engine.GetModule("user").data.value();
+		user->AddSectionFromMemory(userSource);
+		return user->LoadCompiled(file);
+	};
+	Check(load(bytes) == mlang::RespCode::SUCCESS, __func__, __LINE__);
+	if (found.size() == 1) {
+		bytes.replace(found[0], 5, "Large");
+		Check(load(bytes) != mlang::RespCode::SUCCESS, __func__, __LINE__);
+	}
+	std::filesystem::remove(file);
+}
+
+// Functions called often enough run as machine code, the results must stay the same. A thousand calls or ten thousand iterations make a function hot
+static void TestTiers() {
+	mlang::Engine engine;
+	auto mod = BuildModule(engine, "tiers", R"(
+long total = 0;
+void add(int x) { total = total + x; }
+long loop(int n) { long acc = 0; int i = 0; while (i < n) { acc = acc + i * 3; i = i + 1; } return acc; }
+double mixed(int n) { double d = 0; short s = 1; int i = 0; while (i < n) { d = d + i / 2; s = s * 3; i = i + 1; } return d + s; }
+char wrap(char c) { char d = c * 20; return d + 120; }
+long calls(int n) { int i = 0; while (i < n) { add(1); i = i + 1; } return total; }
+int main(){ return 0; }
+)");
+	Check(mod, __func__, __LINE__);
+	if (!mod) return;
+
+	auto loop = mod->GetFunction<int64_t(int)>("loop").data.value();
+	auto mixed = mod->GetFunction<double(int)>("mixed").data.value();
+	auto wrap = mod->GetFunction<int(int)>("wrap").data.value();
+
+	auto firstLoop = loop(1000).data.value();
+	auto firstMixed = mixed(101).data.value();
+	auto firstWrap = wrap(10).data.value();
+	Check(firstLoop == 1498500, __func__, __LINE__);
+
+	for (int i = 0; i < 2000; ++i) {
+		if (loop(1000).data.value() != firstLoop || mixed(101).data.value() != firstMixed || wrap(10).data.value() != firstWrap) {
+			Check(false, __func__, __LINE__);
+			break;
+		}
+	}
+
+	Check(Call<int64_t(int)>(mod, "calls", 30000).data.value() == 30000, __func__, __LINE__);
+}
+
+// The library is built with the command in MLANG_TEST_CXX, given the source and '-o' with the library. Skipped without a compiler
+static void TestTranspile() {
+#if defined(WIN32) || defined(_WIN32)
+	auto compiler = std::getenv("MLANG_TEST_CXX");
+	auto library = TempPath("mlang_tests_aot.dll");
+#else
+	auto compiler = std::getenv("MLANG_TEST_CXX") ? std::getenv("MLANG_TEST_CXX") : "c++ -O1 -shared -fPIC";
+	auto library = TempPath("mlang_tests_aot.so");
+#endif
+	if (!compiler) {
+		std::cout << __func__ << " skipped, MLANG_TEST_CXX isn't set\n";
+		return;
+	}
+
+	mlang::Engine engine;
+	auto mod = BuildModule(engine, "aot", R"(
+int fib(int n) { if (n < 2) { return n; } return fib(n - 1) + fib(n - 2); }
+int div(int a, int b) { return a / b; }
+long forever(long n) { return forever(n + 1); }
+double scale(int x, float f) { return x * f + 10; }
+int main(){ return 0; }
+)");
+	Check(mod, __func__, __LINE__);
+	if (!mod) return;
+
+	auto source = TempPath("mlang_tests_aot.cpp");
+	Check(mod->Transpile(source) == mlang::RespCode::SUCCESS, __func__, __LINE__);
+	if (std::system((std::string(compiler) + " \"" + source + "\" -o \"" + library + "\"").c_str()) != 0) {
+		std::cout << __func__ << " skipped, '" << compiler << "' couldn't build the library\n";
+		std::filesystem::remove(source);
+		return;
+	}
+	Check(mod->LoadNative(library) == mlang::RespCode::SUCCESS, __func__, __LINE__);
+
+	Check(Call<int(int)>(mod, "fib", 20).data.value() == 6765, __func__, __LINE__);
+	Check(Call<int(int, int)>(mod, "div", INT_MIN, -1).data.value() == INT_MIN, __func__, __LINE__);
+	Check(Call<double(int, float)>(mod, "scale", 3, 0.5f).data.value() == 11.5, __func__, __LINE__);
+	// Native code reports failures instead of throwing or overflowing the host's stack
+	Check(Call<int(int, int)>(mod, "div", 1, 0).code != mlang::RespCode::SUCCESS, __func__, __LINE__);
+	Check(Call<int64_t(int64_t)>(mod, "forever", int64_t(0)).code != mlang::RespCode::SUCCESS, __func__, __LINE__);
+	Check(Call<int(int)>(mod, "fib", 10).data.value() == 55, __func__, __LINE__);
+
+	// Libraries of other sources aren't loaded
+	mlang::Engine other;
+	other.NewModule("aot");
+	auto changed = other.GetModule("aot").data.value();
+	changed->AddSectionFromMemory("int fib(int n) { return n; }\nint main(){ return 0; }\n");
+	Check(changed->Build() == mlang::RespCode::SUCCESS && changed->LoadNative(library) != mlang::RespCode::SUCCESS, __func__, __LINE__);
+
+	std::filesystem::remove(source);
+}
+
+static void TestFolding() {
+	std::string sum = "0";
+	int64_t expected = 0;
+	for (int i = 1; i < 2000; ++i) {
+		sum += " + " + std::to_string(i);
+		expected += i;
+	}
+
+	mlang::Engine engine;
+	auto mod = BuildModule(engine, "fold", "long sum() { return " + sum + "; }\n"
+		"long day() { long s = 60 * 60 * 24 * 365; return s * 1000; }\n"
+		"int scopes(int x) { int r = 0; if (x > 0) { const int a = 40; r = a + 2; } if (x > 1) { const char c = 300; r = r + c; } return r; }\n"
+		"int folded() { const int m1 = 0 - 1; const int lo = 0 - 2147483647; const int min = lo - 1; return min / m1; }\n"
+		"int guarded(int x) { const int z = 0; if (x > 0) { return x / z; } return 9; }\n"
+		"int main(){ return 0; }\n");
+	Check(mod, __func__, __LINE__);
+	if (!mod) return;
+
+	Check(Call<int64_t()>(mod, "sum").data.value() == expected, __func__, __LINE__);
+	Check(Call<int64_t()>(mod, "day").data.value() == 31536000000ll, __func__, __LINE__);
+	Check(Call<int(int)>(mod, "scopes", 1).data.value() == 42, __func__, __LINE__);
+	Check(Call<int(int)>(mod, "scopes", 2).data.value() == 42 + static_cast<char>(300), __func__, __LINE__);
+	Check(Call<int()>(mod, "folded").data.value() == INT_MIN, __func__, __LINE__);
+
+	// Division by zero isn't folded, it fails only when it runs
+	Check(Call<int(int)>(mod, "guarded", 0).data.value() == 9, __func__, __LINE__);
+	bool threw = false;
+	try {
+		Call<int(int)>(mod, "guarded", 1);
+	}
+	catch (const std::exception &) {
+		threw = true;
+	}
+	Check(threw, __func__, __LINE__);
+}
+
+static void TestInlining() {
+	mlang::Engine engine;
+	auto mod = BuildModule(engine, "inline", R"(
+class Counter{
+	int count;
+	public:
+	int Next() { count = count + 1; return count; }
+};
+Counter counter;
+int square(int x) { return x * x; }
+int clamp(int x) { if (x > 100) { return 100; } return x; }
+void nothing(int x) { int y = x; }
+int sumSquares(int n) { int s = 0; int i = 0; while (i < n) { s = s + clamp(square(i)); nothing(i); i = i + 1; } return s; }
+int next() { return counter.Next(); }
+int main(){ return 0; }
+)");
+	Check(mod, __func__, __LINE__);
+	if (!mod) return;
+
+	int expected = 0;
+	for (int i = 0; i < 50; ++i) expected += std::min(i * i, 100);
+	Check(Call<int(int)>(mod, "sumSquares", 50).data.value() == expected, __func__, __LINE__);
+
+	Call<int()>(mod, "next");
+	Check(Call<int()>(mod, "next").data.value() == 2, __func__, __LINE__);
+}
+
+int main() {
+	TestCalls();
+	TestArithmetic();
+	TestDivision();
+	TestNative();
+	TestContexts();
+	TestBuildModules();
+	TestSaveLoad();
+	TestHostileFiles();
+	TestTiers();
+	TestTranspile();
+	TestFolding();
+	TestInlining();
+
+	if (failures) std::cerr << failures << " checks failed\n";
+	else std::cout << "All checks passed\n";
+	return failures;
+}
@@ -2,14 +2,20 @@
 
 #include <string>
 #include <vector>
+#include <array>
+#include <deque>
 #include <cstddef>
 #include <memory>
+#include <new>
 #include <cstdint>
 #include <algorithm>
 #include <unordered_map>
 #include <functional>
 #include <optional>
 #include <variant>
+#include <shared_mutex>
+#include <atomic>
+#include <tuple>
 #include <string_view>
 #include <type_traits>
 #include <concepts>
@@ -23,6 +29,13 @@ namespace mlang {
 	class ScriptFunc;
 	class ScriptRval;
 	class Scope;
+	class ExecutionContext;
+	struct Bytecode;
+	struct OptimizedCode;
+	struct TypedState;
+	struct TypedInstruction;
+	template<typename Signature>
+	class FunctionHandle;
 
 	enum class RespCode : int {
 		ERR = -1,
@@ -37,12 +50,130 @@ namespace mlang {
 		Response(T val, RespCode code_) : data{ val }, code(code_) {}
 	};
 
+	// How a primitive is stored, NONE for void and classes. Same order as Engine::Primitive
+	enum class NumericKind : uint8_t {
+		NONE,
+		BOOL,
+		INT8,
+		INT16,
+		INT32,
+		INT64,
+		UINT8,
+		UINT16,
+		UINT32,
+		UINT64,
+		FLOAT,
+		DOUBLE,
+		COUNT
+	};
+
+	// The C++ type a numeric kind is stored as
+	template<NumericKind K> struct KindType { using Type = void; };
+	template<> struct KindType<NumericKind::BOOL> { using Type = bool; };
+	template<> struct KindType<NumericKind::INT8> { using Type = int8_t; };
+	template<> struct KindType<NumericKind::INT16> { using Type = int16_t; };
+	template<> struct KindType<NumericKind::INT32> { using Type = int32_t; };
+	template<> struct KindType<NumericKind::INT64> { using Type = int64_t; };
+	template<> struct KindType<NumericKind::UINT8> { using Type = uint8_t; };
+	template<> struct KindType<NumericKind::UINT16> { using Type = uint16_t; };
+	template<> struct KindType<NumericKind::UINT32> { using Type = uint32_t; };
+	template<> struct KindType<NumericKind::UINT64> { using Type = uint64_t; };
+	template<> struct KindType<NumericKind::FLOAT> { using Type = float; };
+	template<> struct KindType<NumericKind::DOUBLE> { using Type = double; };
+
+	template<typename T>
+	constexpr NumericKind KindOf() {
+		using Type = std::remove_cv_t<T>;
+		if constexpr (std::is_same_v<Type, bool>) return NumericKind::BOOL;
+		else if constexpr (std::is_floating_point_v<Type>) return (sizeof(Type) == 4 ? NumericKind::FLOAT : NumericKind::DOUBLE);
+		else if constexpr (std::is_integral_v<Type>) {
+			constexpr auto base = (std::is_unsigned_v<Type> ? NumericKind::UINT8 : NumericKind::INT8);
+			constexpr auto step = (sizeof(Type) == 1 ? 0 : sizeof(Type) == 2 ? 1 : sizeof(Type) == 4 ? 2 : 3);
+			return static_cast<NumericKind>(static_cast<int>(base) + step);
+		}
+		else return NumericKind::NONE;
+	}
+
+	// Primitive conversions, one function per (source kind, destination kind) pair behaving like a C cast
+	using Conversion = void (*)(const void *src, void *dest);
+	constexpr size_t numericKindCount = static_cast<size_t>(NumericKind::COUNT);
+	extern const std::array<Conversion, numericKindCount * numericKindCount> conversions;
+
+	// Null if either side isn't numeric
+	inline Conversion GetConversion(NumericKind from, NumericKind to) {
+		return conversions[static_cast<size_t>(from) * numericKindCount + static_cast<size_t>(to)];
+	}
+	// For when both kinds are known while compiling the host
+	template<NumericKind From, NumericKind To>
+	void Convert(const void *src, void *dest) {
+		using Dest = typename KindType<To>::Type;
+		*static_cast<Dest *>(dest) = static_cast<Dest>(*static_cast<const typename KindType<From>::Type *>(src));
+	}
+
+	// Binary operators, one function per (lhs kind, rhs kind) pair. Operands are promoted to their common kind first
+	using Kernel = void (*)(const void *lhs, const void *rhs, void *out);
+
+	// Calls a registered C++ function, its parameters are read from the call frame and the result written to 'ret'
+	using NativeThunk = void (*)(void *target, const char *frame, void *ret);
+	// Entry of a function transpiled by Module::Transpile, reads its parameters from the call frame like a thunk. Returns an AotError
+	using AotFunction = int (*)(char *frame, void *ret, char *globals);
+	enum class AotError : int {
+		NONE,
+		DIVISION_BY_ZERO,
+		STACK_OVERFLOW
+	};
+
+	// Interned identifier, equal names share the same id
+	using Symbol = uint32_t;
+
+	// Modules built in parallel intern into the same table
+	class SymbolTable final {
+		std::deque<std::string> names;	// Never moves its strings, the views below stay valid
+		std::unordered_map<std::string_view, Symbol> ids;
+		mutable std::shared_mutex mutex;
+
+		public:
+		static constexpr Symbol none = 0;	// The empty name
+
+		SymbolTable() { Intern(""); }
+
+		Symbol Intern(std::string_view name);
+		Response<Symbol> Find(std::string_view name) const;
+		inline std::string_view Name(Symbol symbol) const {
+			std::shared_lock lock(mutex);
+			return names[symbol];
+		}
+		inline size_t Size() const {
+			std::shared_lock lock(mutex);
+			return names.size();
+		}
+	};
+
 	class Engine final {
+		public:
+		// Primitives are registered first, in this order, so their TIDs are fixed
+		enum class Primitive : size_t {
+			VOID,
+			BOOL,
+			INT8,
+			INT16,
+			INT32,
+			INT64,
+			UINT8,
+			UINT16,
+			UINT32,
+			UINT64,
+			FLOAT,
+			DOUBLE,
+			COUNT
+		};
+
 		private:
 		std::unordered_map<std::string, std::unique_ptr<Module>> modules;
+		SymbolTable symbols;
 		Scope *globalScope;
 		Scope *currScope;
-		size_t typeIndex = 0;
+		std::vector<TypeInfo *> typeTable;	// Indexed by TID, names go through the global scope's index
 
 		public:
 		Engine();
@@ -52,6 +183,10 @@ namespace mlang {
 		Response<Module*> GetModule(const std::string &name) const;
 		RespCode DestroyModule(const std::string &name);
 
+		// Builds the modules like calling Build on each in order, tokenizing and parsing them on 'threadCount' threads (0 for one per core).
+		// Classes of modules built by the same call can't be used by each other
+		RespCode BuildModules(const std::vector<std::string> &names, size_t threadCount = 0);
+
 		Scope *GetScope() const;
 		void SetScope(Scope *scope);
 
@@ -59,13 +194,97 @@ namespace mlang {
 		Response<size_t> GetTypeIdxByName(const std::string &name) const;
 		TypeInfo *GetTypeInfoByIdx(size_t idx) const;
 		TypeInfo *GetTypeInfoByName(const std::string &name) const;
+		inline TypeInfo *GetPrimitive(Primitive primitive) const { return typeTable[static_cast<size_t>(primitive)]; }
 
-		RespCode RegisterFunction(const std::string &name, const std::string &params, TypeInfo *returnType, const std::function<ScriptRval()> &func);
+		// Makes a C++ function pointer or lambda callable from scripts, its parameters and return type must be primitives or void.
+		// Captureless lambdas are called directly, function pointers through the pointer
+		template<typename F>
+		RespCode RegisterFunction(const std::string &name, F func);
 
-		size_t GenerateTID() { return typeIndex++; }
+		private:
+		void AddPrimitive(const std::string &name, size_t size, NumericKind kind, bool isUnsigned = false);
+		RespCode RegisterNative(const std::string &name, NativeThunk thunk, std::shared_ptr<void> target, TypeInfo *returnType, std::vector<TypeInfo *> &&paramTypes, const size_t *paramOffsets);
+
+		public:
+
+		// Gives 'type' the next TID and makes it reachable by it
+		TypeInfo *RegisterTypeID(TypeInfo *type);
+		inline size_t TypeIDCount() const { return typeTable.size(); }
+		// Takes back the TIDs given from 'count' on, to the classes of a module that failed to link
+		inline void TruncateTypeIDs(size_t count) { typeTable.resize(count); }
+
+		SymbolTable &Symbols() { return symbols; }
+		const SymbolTable &Symbols() const { return symbols; }
+	};
+
+	// Bump allocator, everything allocated from it is released at once
+	class Arena final {
+		struct Finalizer {
+			void (*destroy)(void *);
+			void *obj;
+		};
+
+		static constexpr size_t blockSize = 16 * 1024;
+		std::vector<std::unique_ptr<char[]>> blocks;
+		std::vector<Finalizer> finalizers;	// Only for objects that aren't trivially destructible
+		char *curr = nullptr;
+		size_t left = 0;
+
+		public:
+		Arena() = default;
+		Arena(const Arena &) = delete;
+		Arena &operator=(const Arena &) = delete;
+		~Arena() { Reset(); }
+
+		void *Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+		void Reset();
+
+		template<typename T, typename... Args>
+		T *New(Args &&...args) {
+			T *ret = new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+
+			if constexpr (!std::is_trivially_destructible_v<T>) {
+				finalizers.push_back(Finalizer{ [](void *obj) { static_cast<T *>(obj)->~T(); }, ret });
+			}
+			return ret;
+		}
 	};
+	template<typename T>
+	struct ArenaAllocator {
+		using value_type = T;
+		Arena *arena;
+
+		ArenaAllocator(Arena *arena_) : arena(arena_) {}
+		template<typename U>
+		ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
 
-	// AST nodes
+		T *allocate(size_t n) { return static_cast<T *>(arena->Allocate(n * sizeof(T), alignof(T))); }
+		void deallocate(T *, size_t) {}	// Freed with the arena
+
+		template<typename U>
+		bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+	};
+	template<typename T>
+	using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+	// Whole file mapped read only, views into it stay valid until it's closed
+	class MappedFile final {
+		const char *data = nullptr;
+		size_t size = 0;
+
+		public:
+		MappedFile() = default;
+		MappedFile(const MappedFile &) = delete;
+		MappedFile &operator=(const MappedFile &) = delete;
+		~MappedFile() { Close(); }
+
+		RespCode Open(const std::string &path);
+		void Close();
+
+		inline std::string_view View() const { return std::string_view(data, size); }
+	};
+
+	// AST nodes, allocated from their module's arena
 	struct Token {
 		enum class Type : int {
 			IDENTIFIER,					// [a-zA-Z_]+([a-zA-Z0-9_]*)?
@@ -146,11 +365,37 @@ namespace mlang {
 
 		int row, col;
 		Type type;
-		std::string val;
+		std::string_view val;	// Into the module's source, or the symbol table for joined names
+		Symbol sym = SymbolTable::none;	// Identifiers only
 
-		Token(Type type_ = Type::END, const std::string &val_ = "", int row_ = 0, int col_ = 0)
-			:type(type_), val(val_), row(row_), col(col_) {}
+		Token(Type type_ = Type::END, std::string_view val_ = {}, int row_ = 0, int col_ = 0, Symbol sym_ = SymbolTable::none)
+			:type(type_), val(val_), row(row_), col(col_), sym(sym_) {}
+	};
+	// What a name refers to, computed once by the resolver
+	struct Binding {
+		enum class Kind : uint8_t {
+			UNRESOLVED,
+			OBJECT,
+			FUNCTION,
+			METHOD,		// Method called on an object located like OBJECT
+		};
+		enum class Base : uint8_t {
+			STATIC,		// Object of another module, relative to the running context's copy of that module's globals
+			GLOBAL,		// Module level object, relative to the running context's globals
+			FRAME,		// Local of the running function, relative to its call frame
+			THIS		// Member of the method's object
+		};
+		Kind kind = Kind::UNRESOLVED;
+		Base base = Base::STATIC;
+		bool isConst = false;
+		bool isPublic = true;
+		const Module *module = nullptr;		// Owner of a STATIC object
+		size_t offset = 0;
+		const TypeInfo *type = nullptr;
+		ScriptFunc *func = nullptr;
+		std::string error;		// Reported when the bound code runs
 	};
+
 	struct Expression {
 		enum class Type {
 			VALUE,
@@ -173,18 +418,35 @@ namespace mlang {
 		BinaryExpr(Expression *lhs_, const Token &op_, Expression *rhs_)
 			:lhs(lhs_), rhs(rhs_), op(op_), Expression(Expression::Type::BINARY) {}
 	};
+	// Numeric literal parsed once, its type is the smallest of int, long, float, double holding it
+	struct Literal {
+		Engine::Primitive type = Engine::Primitive::INT32;
+		union {
+			int32_t i32;
+			int64_t i64;
+			float f32;
+			double f64;
+		};
+
+		Literal() : i64(0) {}
+
+		static std::optional<Literal> Parse(std::string_view text);
+	};
 	struct ValueExpr : public Expression {
 		Token val;
+		Literal literal;	// INTEGER and DECIMAL tokens only
+		Binding binding;
 
-		ValueExpr(const Token &val_)
-			:val(val_), Expression(Expression::Type::VALUE) {}
+		ValueExpr(const Token &val_, const Literal &literal_ = Literal())
+			:val(val_), literal(literal_), Expression(Expression::Type::VALUE) {}
 	};
 	struct FuncCallExpr : public Expression {
 		Token funcName;
-		std::vector<Expression *> params;
+		ArenaVector<Expression *> params;
+		Binding binding;
 
-		FuncCallExpr(const Token &name, const std::vector<Expression*> &parameters)
-			:funcName(name), params(parameters), Expression(Expression::Type::FUNCCALL) {}
+		FuncCallExpr(const Token &name, ArenaVector<Expression*> &&parameters)
+			:funcName(name), params(std::move(parameters)), Expression(Expression::Type::FUNCCALL) {}
 	};
 	
 	struct Statement {
@@ -212,24 +474,23 @@ namespace mlang {
 		Token type;
 		Token ident;
 		Expression *expr;
+		Binding binding;
 
 		VarDeclStmt(const Token &type_, const Token &ident_, Expression *expr_)
 			:type(type_), ident(ident_), expr(expr_), Statement(Statement::Type::VARDECL) {}
-		~VarDeclStmt() { delete expr; }
 	};
 	struct VarAssignStmt : public Statement {
 		Token ident;
 		Expression *expr;
+		Binding binding;
 
 		VarAssignStmt(const Token &ident_, Expression *expr_)
 			:ident(ident_), expr(expr_), Statement(Statement::Type::ASSIGNEMENT) {}
-		~VarAssignStmt() { delete expr; }
 	};
 	struct BlockStmt : public Statement {
-		std::vector<Statement *> stmts;
+		ArenaVector<Statement *> stmts;
 
-		BlockStmt(): Statement(Statement::Type::BLOCK) {}
-		~BlockStmt() { for(auto &stmt: stmts) delete stmt; }
+		BlockStmt(Arena *arena): stmts(arena), Statement(Statement::Type::BLOCK) {}
 
 		inline void AddStatement(Statement *stmt) { stmts.push_back(stmt); }
 		inline void RemoveStatement(Statement *stmt) { 
@@ -237,20 +498,14 @@ namespace mlang {
 		}
 	};
 	struct FuncStmt: public Statement {
-		std::vector<Statement *> params;
+		ArenaVector<Statement *> params;
 		Statement *block;
 		Token ident;
 		Token type;
 		Scope *funcScope = nullptr;
 
-		FuncStmt(const std::vector<Statement *> &params_, Statement *block_, const Token &retType, const Token &ident_)
-			:params(params_), block(block_), type(retType), ident(ident_), Statement(Statement::Type::FUNCDEF) {}
-		~FuncStmt() {
-			for (auto &param : params) {
-				delete param;
-			}
-			delete block;
-		}
+		FuncStmt(ArenaVector<Statement *> &&params_, Statement *block_, const Token &retType, const Token &ident_)
+			:params(std::move(params_)), block(block_), type(retType), ident(ident_), Statement(Statement::Type::FUNCDEF) {}
 	};
 	struct IfStmt : public Statement {
 		Statement *then;
@@ -261,11 +516,6 @@ namespace mlang {
 
 		IfStmt(Statement *then_, Expression *cond, Statement *els_)
 			: then(then_), condition(cond), els(els_), Statement(Statement::Type::IF) {}
-		~IfStmt() {
-			delete then;
-			delete condition;
-			delete els;
-		}
 	};
 	struct WhileStmt : public Statement {
 		Expression *cond;
@@ -274,10 +524,6 @@ namespace mlang {
 
 		WhileStmt(Expression *cond_, Statement *then_)
 			:cond(cond_), then(then_), Statement(Statement::Type::WHILE) {}
-		~WhileStmt() {
-			delete cond;
-			delete then;
-		}
 	};
 	struct ForStmt : public Statement {
 		Statement *start;
@@ -289,32 +535,22 @@ namespace mlang {
 
 		ForStmt(Statement *start_, Expression *cond_, Statement *end_, Statement *then_)
 			:start(start_), cond(cond_), end(end_), then(then_), Statement(Statement::Type::FOR) {}
-		~ForStmt() {
-			delete start;
-			delete cond;
-			delete end;
-			delete then;
-		}
 	};
 	struct ReturnStmt : public Statement {
 		Expression *val;
 
 		ReturnStmt(Expression *val_) : val(val_), Statement(Statement::Type::RETURN) {}
-		~ReturnStmt() { delete val; }
 	};
 	struct BreakStmt : public Statement {
 		BreakStmt() : Statement(Statement::Type::BREAK) {}
 	};
 	struct FuncCallStmt : public Statement {
 		Token funcName;
-		std::vector<Expression*> params;
+		ArenaVector<Expression*> params;
+		Binding binding;
 
-		FuncCallStmt(const Token &name, const std::vector<Expression*> &param)
-			:funcName(name), params(param), Statement(Statement::Type::FUNCCALL) {}
-		~FuncCallStmt() {
-			for (auto param : params)
-				delete param;
-		}
+		FuncCallStmt(const Token &name, ArenaVector<Expression*> &&param)
+			:funcName(name), params(std::move(param)), Statement(Statement::Type::FUNCCALL) {}
 	};
 
 	class TypeInfo final {
@@ -324,12 +560,20 @@ namespace mlang {
 			PROTECTED,
 			PRIVATE
 		};
+		// Where a member lives inside every instance of its class
+		struct Member {
+			std::string name;
+			TypeInfo *type;
+			size_t offset;
+			Visibility visibility;
+		};
 		private:
 		// General info
 		size_t typeID;
 		std::string name;
 		size_t typeSz;
 		bool unsig;
+		NumericKind kind = NumericKind::NONE;
 		Engine *engine;
 
 		// Member info
@@ -339,9 +583,9 @@ namespace mlang {
 		// Class info
 		bool isClass;
 		std::vector<TypeInfo *> baseClasses;	// Derivations
-		std::unordered_map<std::string, TypeInfo *> members = {};
+		std::vector<Member> members = {};		// Declaration order, instances are laid out the same way
+		std::unordered_map<std::string, size_t> memberIndices = {};
 		std::unordered_map<std::string, ScriptFunc *> methods = {};
-		Visibility visibility = Visibility::PUBLIC;
 
 		public:
 		friend class Engine;
@@ -362,16 +606,19 @@ namespace mlang {
 		inline size_t Size() const { return typeSz; }
 		inline size_t Offset() const { return offset; }
 		inline bool IsUnsigned() const { return unsig; }
+		inline NumericKind Kind() const { return kind; }
 
 		inline TypeInfo *GetParentClass() const { return parentClass; }
 		bool IsBaseOf(const TypeInfo *type) const;
 		inline bool IsClass() const { return isClass; }
 
-		RespCode AddMember(const std::string &name, TypeInfo *type);
-		inline std::optional<TypeInfo *> GetMember(const std::string &name) const {
-			if (!members.contains(name)) return std::nullopt;
-			return members.at(name);
+		// Places the member after the last one and grows the type
+		RespCode AddMember(const std::string &name, TypeInfo *type, Visibility visibility = Visibility::PUBLIC);
+		inline std::optional<const Member *> GetMember(const std::string &name) const {
+			if (!memberIndices.contains(name)) return std::nullopt;
+			return &members[memberIndices.at(name)];
 		}
+		inline const std::vector<Member> &GetMembers() const { return members; }
 
 		RespCode AddMethod(const std::string &name, ScriptFunc *function);
 		inline std::optional<ScriptFunc *> GetMethod(const std::string &name) const {
@@ -392,10 +639,9 @@ namespace mlang {
 		const TypeInfo *type;
 		Engine *engine;
 		std::string identifier;
-		void *ptr = nullptr;
-		std::unordered_map<std::string, ScriptObject *> members;
-		ScriptObject *parentClass;
-		Scope *classScope = nullptr;
+		void *ptr = nullptr;		// Members are at their TypeInfo offsets inside the buffer
+		size_t frameOffset = 0;		// Function locals live in the call frame, module level objects in each context's globals
+		const Module *module = nullptr;	// Module level objects only
 		bool shouldDealloc;
 		size_t refCount = 1;
 		Modifier modifiers;
@@ -407,14 +653,14 @@ namespace mlang {
 		friend class TypeInfo;
 		friend class ScriptRval;
 
-		ScriptObject(Engine *engine, const TypeInfo *type, Modifier mods = (Modifier)0, bool shouldAlloc = true, ScriptObject *parentClass = nullptr);
-		ScriptObject(Engine *engine, const TypeInfo *type, ScriptRval &rvalue, Modifier mods = (Modifier)0, bool alloc = true, ScriptObject *parentClass = nullptr);
+		ScriptObject(Engine *engine, const TypeInfo *type, Modifier mods = (Modifier)0, bool shouldAlloc = true);
+		ScriptObject(Engine *engine, const TypeInfo *type, ScriptRval &rvalue, Modifier mods = (Modifier)0, bool alloc = true);
 		~ScriptObject();
 
 		TypeInfo const *GetType() const { return type; }
 		const std::string &GetName() const { return identifier; }
 
-		std::optional<ScriptObject *> GetMember(const std::string &name) const;
+		std::optional<void *> GetMemberAddress(const std::string &name) const;
 
 		bool IsModifier(Modifier mod) const { return static_cast<int>(modifiers) & static_cast<int>(mod); }
 		void SetType(Modifier mod) { modifiers = static_cast<Modifier>(static_cast<int>(modifiers) | static_cast<int>(mod)); }
@@ -426,6 +672,10 @@ namespace mlang {
 		RespCode SetVal(ScriptRval &value);
 		RespCode SetVal(const ScriptObject *value);
 
+		// Writes 'value' into raw storage of type 'type', converting primitives
+		static RespCode StoreVal(const TypeInfo *type, void *ptr, ScriptRval &value);
+		static RespCode StoreFrom(const TypeInfo *type, void *ptr, const TypeInfo *srcType, const void *src);
+
 		Engine *GetEngine() const { return engine; }
 
 		RespCode CallMethod(const std::string &name);
@@ -433,14 +683,39 @@ namespace mlang {
 		static ScriptObject *Clone(ScriptObject *original);
 	};
 	class ScriptFunc final {
+		public:
+		// Where a parameter is stored in the function's call frame
+		struct Param {
+			const TypeInfo *type;
+			size_t offset;
+		};
+
 		private:
 		std::string name;
 		size_t paramCount;
 
 		FuncStmt *func = nullptr;
 		ScriptObject *object = nullptr;
+		std::unique_ptr<Bytecode> code;
+		std::vector<Param> params;
+		size_t frameSize = 0;
+		const Module *module = nullptr;	// Owner of the bytecode
+
+		// Translated when it's built if it only uses primitives, compiled to machine code once it's called or loops often enough
+		static constexpr uint32_t hotCalls = 1000;
+		static constexpr uint32_t hotIterations = 10000;
+		std::unique_ptr<OptimizedCode> optimized;
+		std::atomic<uint32_t> calls = 0;
+		std::atomic<uint32_t> iterations = 0;
+
+		// Registered C++ functions have no statement or bytecode
+		NativeThunk native = nullptr;
+		std::shared_ptr<void> nativeTarget;
+		// Set by Module::LoadNative, runs instead of the bytecode
+		AotFunction aot = nullptr;
 
 		TypeInfo *returnType;
+		TypeInfo *classType = nullptr;
 		bool isMethod, isConstMethod;
 		TypeInfo::Visibility methodVisibility = TypeInfo::Visibility::PUBLIC;
 
@@ -448,8 +723,9 @@ namespace mlang {
 		friend class Engine;
 		friend class Module;
 		friend class Scope;
+		friend class ExecutionContext;
 
-		ScriptFunc(const std::string &name, size_t params, FuncStmt *stmt = nullptr, TypeInfo *ret = nullptr, bool method = false, ScriptObject *obj = nullptr, bool constMethod = false)
+		ScriptFunc(const std::string &name, size_t params, FuncStmt *stmt = nullptr, TypeInfo *ret = nullptr, bool method = false, bool constMethod = false)
 			: name(name), paramCount(params), func(stmt), returnType(ret), isMethod(method), isConstMethod(constMethod) {}
 
 		void SetClassObject(ScriptObject *obj);
@@ -457,8 +733,95 @@ namespace mlang {
 
 		const std::string &GetName() const { return name; }
 		size_t GetParamCount() const { return paramCount; }
+		const std::vector<Param> &GetParams() const { return params; }
+		const TypeInfo *GetReturnType() const { return returnType; }
 		FuncStmt *GetUnderlyingFunc() const { return func; }
+		bool IsNative() const { return native != nullptr; }
+		bool IsOptimized() const { return optimized != nullptr; }
+
+		private:
+		// Translates the bytecode, the function stays with it if it uses anything that isn't a primitive
+		void Optimize();
+		void CompileNative();
 	};
+
+	// Marshalling for Engine::RegisterFunction
+	namespace native {
+		template<typename F>
+		struct Signature : Signature<decltype(&F::operator())> {};
+		template<typename R, typename... Args>
+		struct Signature<R(*)(Args...)> {
+			using Return = R;
+			using Params = std::tuple<std::decay_t<Args>...>;
+		};
+		template<typename C, typename R, typename... Args>
+		struct Signature<R(C:: *)(Args...)> : Signature<R(*)(Args...)> {};
+		template<typename C, typename R, typename... Args>
+		struct Signature<R(C:: *)(Args...) const> : Signature<R(*)(Args...)> {};
+
+		// Same layout the resolver gives script parameters, each one aligned to its size
+		template<typename... Args>
+		constexpr std::array<size_t, sizeof...(Args)> FrameOffsets() {
+			std::array<size_t, sizeof...(Args)> ret{};
+			size_t frameSize = 0, i = 0;
+			((frameSize = (frameSize + sizeof(Args) - 1) / sizeof(Args) * sizeof(Args), ret[i++] = frameSize, frameSize += sizeof(Args)), ...);
+
+			return ret;
+		}
+
+		// Captureless lambdas have no state, they're called without a target
+		template<typename F>
+		constexpr bool isStateless = std::is_empty_v<F> && std::is_default_constructible_v<F>;
+
+		template<typename F, typename R, typename... Args, size_t... I>
+		void Call(void *target, const char *frame, void *ret, std::index_sequence<I...>) {
+			static constexpr auto offsets = FrameOffsets<Args...>();
+			auto call = [&](auto &&func) {
+				if constexpr (std::is_void_v<R>) {
+					func(*reinterpret_cast<const Args *>(frame + offsets[I])...);
+				}
+				else {
+					*static_cast<R *>(ret) = func(*reinterpret_cast<const Args *>(frame + offsets[I])...);
+				}
+			};
+
+			if constexpr (isStateless<F>) call(F{});
+			else call(*static_cast<F *>(target));
+		}
+		template<typename F, typename R, typename Params>
+		struct Thunk;
+		template<typename F, typename R, typename... Args>
+		struct Thunk<F, R, std::tuple<Args...>> {
+			static void Invoke(void *target, const char *frame, void *ret) {
+				Call<F, R, Args...>(target, frame, ret, std::index_sequence_for<Args...>());
+			}
+		};
+	}
+
+	template<typename F>
+	RespCode Engine::RegisterFunction(const std::string &name, F func) {
+		using Signature = native::Signature<std::decay_t<F>>;
+		using Return = typename Signature::Return;
+
+		static_assert(std::is_void_v<Return> || std::is_arithmetic_v<Return>, "Registered functions can only return primitives or void");
+
+		return [&]<typename... Args>(std::tuple<Args...> *) {
+			static_assert((std::is_arithmetic_v<Args> && ...), "Registered functions can only take primitives");
+			static constexpr auto offsets = native::FrameOffsets<Args...>();
+
+			TypeInfo *returnType = nullptr;
+			if constexpr (std::is_void_v<Return>) returnType = GetPrimitive(Primitive::VOID);
+			else returnType = GetPrimitive(static_cast<Primitive>(KindOf<Return>()));
+
+			std::shared_ptr<void> target;
+			if constexpr (!native::isStateless<std::decay_t<F>>) target = std::make_shared<std::decay_t<F>>(std::move(func));
+
+			return RegisterNative(
+				name, &native::Thunk<std::decay_t<F>, Return, typename Signature::Params>::Invoke, std::move(target),
+				returnType, { GetPrimitive(static_cast<Primitive>(KindOf<Args>()))... }, offsets.data()
+			);
+		}(static_cast<typename Signature::Params *>(nullptr));
+	}
 	
 	template<typename T>
 	concept Rvalueable = requires(T a) {
@@ -470,22 +833,31 @@ namespace mlang {
 	class ScriptRval final {
 		Engine *engine = nullptr;
 		const TypeInfo *valueType;
-		void *data = nullptr;
+		void *data = nullptr;	// Primitives point at inlineData, classes at the object's bytes (owned or referenced)
 		bool reference;
+		alignas(8) char inlineData[8];
 
 		ScriptRval(Engine *engine_, const TypeInfo *valueType_, bool isReference_ = false) : engine(engine_), valueType(valueType_), reference(isReference_) {}
+		inline bool IsInline() const { return data == inlineData; }
+
+		// Runs the kernel of 'Op' for both operands' numeric kinds
+		template<typename Op>
+		ScriptRval Compute(const ScriptRval &other) const;
 		public:
 		friend class Engine;
 		friend class Module;
 		friend class Scope;
 		friend class ScriptObject;
+		friend class ScriptFunc;
+		friend class ExecutionContext;
+		template<typename Signature>
+		friend class FunctionHandle;
 
 		ScriptRval(ScriptRval &&other) noexcept;
 		ScriptRval(const ScriptRval &other);
 		~ScriptRval() {
-			if (reference) return;
-			if (!valueType->isClass) delete data;
-			else delete reinterpret_cast<ScriptObject *>(data);
+			if (reference || IsInline()) return;
+			delete[] reinterpret_cast<char *>(data);
 		}
 
 		template<Rvalueable T>
@@ -493,8 +865,8 @@ namespace mlang {
 			ScriptRval ret(engine, type, isReference);
 			ret.valueType = type;
 
-			if(!isReference)
-				ret.data = new char[type->Size()];
+			if (!isReference)
+				ret.data = (type->IsClass() ? new char[type->Size()] : ret.inlineData);
 			else {
 				if constexpr (!std::is_pointer_v<T>) throw std::exception("Error creating rvalue");
 				else {
@@ -505,8 +877,17 @@ namespace mlang {
 
 			if constexpr (std::is_fundamental_v<T>) {
 				assert(!isReference);
-				ret.valueType = type;
-				std::memcpy(ret.data, &data, type->Size());
+
+				// 'data' is converted to the type's representation
+				if (type->Kind() == KindOf<T>()) {
+					std::memcpy(ret.data, &data, type->Size());
+				}
+				else if (auto convert = GetConversion(KindOf<T>(), type->Kind())) {
+					convert(&data, ret.data);
+				}
+				else {
+					throw std::exception("Error creating rvalue");
+				}
 				return ret;
 			}
 			else if constexpr (std::is_same_v<T, ScriptObject> || std::is_pointer_v<T>) {
@@ -526,6 +907,7 @@ namespace mlang {
 
 		// Only works on primitives
 		static ScriptRval CreateFromLiteral(Engine *engine, const std::string &data);
+		static ScriptRval CreateFromLiteral(Engine *engine, const Literal &literal, const TypeInfo *as = nullptr);
 
 		ScriptRval operator+(const ScriptRval &other) const;
 		ScriptRval operator-(const ScriptRval &other) const;
@@ -548,20 +930,223 @@ namespace mlang {
 		operator bool() const;
 
 		RespCode SetValue(const ScriptRval &other);
+
+		// Copies a primitive, references a class
+		static ScriptRval CreateFromMemory(Engine *engine, const TypeInfo *type, void *ptr);
+
+		// Makes a referenced class value own a copy of the object
+		void Detach();
+	};
+
+	// Bytecode
+	enum class OpCode : uint8_t {
+		PUSH_CONST,		// Pushes constants[arg]
+		LOAD,			// Pushes the value bound by bindings[arg]
+		STORE,			// Pops the top of the stack into bindings[arg]
+		DECLARE,		// Initializes bindings[arg], pops the initializer if arg2 is set
+		POP,
+		FAIL,			// Reports errors[arg]
+
+		ADD,
+		SUB,
+		MUL,
+		DIV,
+		LESS,
+		LEQ,
+		GREATER,
+		GEQ,
+		EQ,
+		NEQ,
+		COMPUTE,		// ADD to NEQ quickened for the operand kinds in arg
+
+		JUMP,			// Jumps to arg
+		JUMP_IF_FALSE,	// Pops the condition, jumps to arg if it's false
+
+		CALL,			// Calls bindings[arg] with arg2 parameters from the stack, pushes the returned value
+		RETURN,			// Returns the top of the stack
+		RETURN_VOID,
+		HALT
+	};
+	// ADD to NEQ rewrite themselves into COMPUTE the first time they run, keeping the operator and both operands' kinds in arg.
+	// They go back to the operator for good once other kinds show up
+	struct Instruction {
+		mutable OpCode op;
+		mutable uint32_t arg = 0;
+		uint32_t arg2 = 0;
+
+		inline bool IsBinary() const { return op >= OpCode::ADD && op <= OpCode::COMPUTE; }
+		// The operator before quickening
+		inline OpCode Generic() const { return (op == OpCode::COMPUTE ? static_cast<OpCode>(arg & 0xff) : op); }
+	};
+	struct Bytecode {
+		std::vector<Instruction> code;
+		std::vector<ScriptRval> constants;
+		std::vector<Binding> bindings;
+		std::vector<std::string> errors;
+	};
+	// Null if the kinds can't be combined by 'op'
+	Kernel GetKernel(OpCode op, NumericKind lhs, NumericKind rhs, NumericKind &result);
+
+	// Code of functions using primitives only, translated when they're built. Every stack value is a raw primitive in a fixed slot,
+	// every instruction runs through a handler chosen for its operation and the kinds it gets
+	enum class TypedOp : uint8_t {
+		CONST,			// slot = constants[arg]
+		LOAD_FRAME,		// slot = 'size' bytes at frame + arg
+		LOAD,			// slot = bindings[arg]
+		STORE_FRAME,	// frame + arg = convert(slot)
+		STORE,			// bindings[arg] = convert(slot)
+		ZERO,			// Clears bindings[arg]
+		COMPUTE,		// slot = kernel(slot, arg)
+		JUMP,			// Jumps to arg
+		LOOP,			// Jumps back to arg, counts the iteration
+		JUMP_IF_FALSE,	// Jumps to arg if slot is false
+		CALL,			// Calls bindings[arg] with arg2 parameters from slot on, converted by conversions[aux] on. The result goes to slot
+		RETURN,			// Returns convert(slot)
+		RETURN_VOID,
+		FAIL,			// Reports errors[arg]
+		NOP
+	};
+	// Runs an instruction, returns the next one or null once the function is left
+	using TypedHandler = const TypedInstruction *(*)(TypedState &state, const TypedInstruction *inst);
+	struct TypedInstruction {
+		TypedOp op = TypedOp::NOP;
+		NumericKind kind = NumericKind::NONE;	// Of the value stored or tested
+		uint8_t size = 0;
+		uint32_t slot = 0;
+		uint32_t arg = 0;
+		uint32_t arg2 = 0;
+		uint32_t aux = 0;
+		NumericKind from = NumericKind::NONE;		// Kind in slot before it's converted or computed
+		NumericKind fromArg = NumericKind::NONE;	// Kind in slot arg, computations only
+		Kernel kernel = nullptr;
+		Conversion convert = nullptr;
+		TypedHandler handler = nullptr;		// Chosen for the instruction's operation, kinds and sizes
+		const TypedInstruction *target = nullptr;	// Of jumps
+	};
+
+	// Machine code of an optimized function, entered at the code of any of its instructions. Returns whether it wrote to 'ret'
+	using JitFunction = bool (*)(char *frame, uint64_t *slots, void *ret, char *globals);
+	// x86-64 code for optimized functions using bool, int, long, float and double locals and module level objects only
+	class JitCode final {
+		void *memory = nullptr;
+		size_t size = 0;
+		std::vector<uint32_t> entries;	// Offset of each instruction's code
+
+		public:
+		JitCode() = default;
+		JitCode(const JitCode &) = delete;
+		JitCode &operator=(const JitCode &) = delete;
+		~JitCode();
+
+		// Null if the code uses anything else or this isn't an x86-64 build
+		static std::unique_ptr<JitCode> Compile(const OptimizedCode &code);
+
+		inline JitFunction Entry(uint32_t idx) const { return reinterpret_cast<JitFunction>(static_cast<char *>(memory) + entries[idx]); }
+	};
+
+	struct OptimizedCode {
+		std::vector<TypedInstruction> code;	// Same indices as the bytecode, loops switch over at their head
+		std::vector<uint64_t> constants;
+		std::vector<Conversion> conversions;
+		std::vector<NumericKind> argKinds;		// Kind each of the conversions converts from
+		const Bytecode *source = nullptr;		// Bindings and errors are the bytecode's
+		const TypeInfo *returnType = nullptr;
+		ScriptFunc *func = nullptr;				// Counts the iterations of loops
+		size_t slotCount = 0;
+		std::atomic<JitCode *> jit = nullptr;	// Runs instead of the instructions once set
+
+		OptimizedCode() = default;
+		OptimizedCode(const OptimizedCode &) = delete;
+		OptimizedCode &operator=(const OptimizedCode &) = delete;
+		~OptimizedCode() { delete jit.load(); }
+	};
+	// What the handlers of a running function work on
+	struct TypedState {
+		ExecutionContext *context;
+		std::vector<ScriptRval> *stack;
+		const OptimizedCode *code;
+		uint64_t *slots;
+		char *frame;
+		uint32_t iterations = 0;
+		RespCode result = RespCode::SUCCESS;
+	};
+
+	// Everything that changes while running a built module. Any number of contexts can run the same module at once, one thread each
+	class ExecutionContext final {
+		static constexpr size_t frameStackSize = 1 << 20;
+		static constexpr size_t maxCallDepth = 4096;
+
+		const Module *module;
+		Engine *engine;
+		std::unique_ptr<char[]> globals;	// Module level objects, at their offsets
+		std::unordered_map<const Module *, std::unique_ptr<char[]>> imported;	// This context's copies of other modules' objects
+		char *moduleGlobals = nullptr;		// Globals of the module whose code is running
+		std::unique_ptr<char[]> frameStack;
+		size_t frameTop = 0;
+		size_t callDepth = 0;
+		char *frame = nullptr;
+		void *thisPtr = nullptr;
+		std::vector<ScriptRval> callStack;	// Used by function handles
+
+		void *Address(const Binding &binding);
+		// The context's objects of 'owner', another module's are initialized by its module level code the first time they're reached
+		char *GlobalsOf(const Module *owner);
+		RespCode Execute(const Bytecode &code, std::vector<ScriptRval> &stack);
+		RespCode ExecuteOptimized(const OptimizedCode &code, std::vector<ScriptRval> &stack);
+		// Runs a quickened operator on the top two values, false if they don't have the kinds it was quickened for
+		bool Compute(uint32_t quickened, std::vector<ScriptRval> &stack) const;
+		// Runs the machine code from instruction 'start' with the slots of the running call
+		void ExecuteNative(const OptimizedCode &code, const JitCode &jit, std::vector<ScriptRval> &stack, uint64_t *slots, uint32_t start);
+
+		// Handlers of optimized instructions. 'Size' bytes are moved as they are, 0 if the value is converted
+		template<TypedOp Op, size_t Size = 0>
+		static const TypedInstruction *Step(TypedState &state, const TypedInstruction *inst);
+		template<TypedOp Op>
+		static TypedHandler Sized(size_t size);
+		static TypedHandler HandlerFor(const TypedInstruction &inst);
+		RespCode Invoke(ScriptFunc *func, std::vector<ScriptRval> &stack, size_t paramCount, void *object = nullptr);
+		// Frame the next call to 'func' gets, null if it doesn't fit
+		char *NextFrame(const ScriptFunc *func) const;
+		// Calls 'func' with its parameters already stored in the next frame, pushes the returned value
+		RespCode Enter(ScriptFunc *func, std::vector<ScriptRval> &stack, void *object = nullptr);
+
+		public:
+		friend class Module;
+		friend class ScriptFunc;
+		template<typename Signature>
+		friend class FunctionHandle;
+
+		explicit ExecutionContext(const Module *module);
+		ExecutionContext(const ExecutionContext &) = delete;
+		ExecutionContext &operator=(const ExecutionContext &) = delete;
+
+		inline const Module *GetModule() const { return module; }
+
+		// Runs the module level code, which initializes this context's objects
+		RespCode Initialize();
+		// Initializes the context and calls main
+		RespCode Run();
 	};
 	
 	class Module final {
 		private:
 		struct Tokenizer {
-			std::string code = "";
+			// Sections are tokenized in the order they were added, tokens view into them
+			std::vector<std::string_view> sections;
+			std::deque<std::string> memorySections;	// Copies of the sections added from memory
+			std::vector<std::unique_ptr<MappedFile>> files;
+
+			std::string_view code;	// Section being tokenized
+			size_t nextSection = 0;
 			int currRow = 1;
 			int currCol = 1;
 			size_t currIdx = 0;
 
-			Tokenizer(const std::string &code_ = "") : code(code_) {}
+			inline void AddSection(std::string_view section) { sections.push_back(section); }
+			Token Tokenize(SymbolTable &symbols);
 
-			inline void AddCode(const std::string &code_) { code += code_; }
-			Token Tokenize();
+			private:
+			Token Make(Token::Type type, size_t length);
 		};
 
 		private:
@@ -573,20 +1158,40 @@ namespace mlang {
 		RespCode errCode = RespCode::SUCCESS;
 
 		std::string name = "";
-		std::unique_ptr<BlockStmt> moduleStmts = nullptr;
+		Arena arena;	// Owns the AST
+
+		// Parser state, declarations go to the module's scope until it's linked
+		std::unique_ptr<Scope> moduleScope;
+		Scope *currScope = nullptr;
+		std::vector<TypeInfo *> classes;
+		bool inMethod = false;
+		bool constMethod = false;
+		BlockStmt *moduleStmts = nullptr;
+		std::vector<ScriptFunc *> functions;
+		std::vector<ScriptObject *> globals;
+		size_t globalsSize = 0;
+		Bytecode moduleCode;
+		std::unique_ptr<ExecutionContext> context;	// Used by Run and handles created without a context
+		std::shared_ptr<void> nativeLibrary;		// Loaded by LoadNative
+
+		// Resolver and compiler state
+		ScriptFunc *currFunc = nullptr;
+		size_t frameSize = 0;
+		std::vector<std::vector<uint32_t>> loopBreaks;
+		std::unordered_map<size_t, ScriptRval> constLocals;	// Values of const locals initialized with constants, by frame offset. Locals never share one
 
 		Token *NextToken();
 		inline Token *GetToken() const { return currTok; }
 		void GoToIndex(size_t idx) { currTokIdx = idx; currTok = &toks[idx]; }
+		// Appends 'next' to a dotted name, the result is interned
+		void JoinToken(Token &tok, const Token &next);
 
 		Expression *ParsePrimaryExpr();
 		Expression *ParseExpression(int precedence = 0);
 
-		std::optional<std::variant<ScriptFunc*, ScriptObject*>> NameResolution(const std::string &name, Scope *scope = nullptr);
-
 		RespCode ParseClass();
 		Statement *ParseBlock();
-		std::vector<Statement *>ParseParams();
+		ArenaVector<Statement *>ParseParams();
 		Statement *ParseWhile();
 		Statement *ParseFor();
 		Statement *ParseIf();
@@ -596,35 +1201,162 @@ namespace mlang {
 		Statement *ParseVarAssign();
 		Statement *ParseStatement();
 
-		RespCode RunWhile(WhileStmt *stmt);
-		RespCode RunFunc(FuncStmt *stmt, std::vector<Expression *> params);
-		RespCode RunFuncCall(FuncCallStmt *stmt);
-		RespCode RunReturn(ReturnStmt *stmt);
-		RespCode RunIf(IfStmt *stmt);
-		RespCode RunBlockStmt(BlockStmt *stmt);
-		RespCode RunVarDeclStmt(VarDeclStmt *stmt);
-		RespCode RunVarAssignStmt(VarAssignStmt *stmt);
-		RespCode RunStmt(Statement *stmt);
-
-		ScriptRval EvaluateExpr(Scope *scope, Expression *expr);
+		Binding ResolveName(const Token &name, Scope *scope, bool isCall);
+		void CheckCall(Binding &binding, const Token &name);
+		void CheckStore(Binding &binding, const Token &name);
+		void ResolveExpr(Expression *expr, Scope *scope);
+		void ResolveStmt(Statement *stmt, Scope *scope);
+		void Resolve();
+
+		// 'op' applied to two constants like the bytecode would, empty if it should be left to run
+		std::optional<ScriptRval> Fold(OpCode op, const ScriptRval &lhs, const ScriptRval &rhs) const;
+		RespCode CompileExpr(Bytecode &code, Expression *expr, const TypeInfo *as = nullptr);
+		RespCode CompileStmt(Bytecode &code, Statement *stmt);
+		RespCode CompileFunc(ScriptFunc *func);
+		// Replaces the caller's calls to small functions of the module with their bytecode, before it's translated
+		void Inline(ScriptFunc *caller);
+		RespCode Compile();
+
+		ScriptFunc *FindFunction(std::string_view name) const;
+
+		// Tokenizes and parses, touches nothing shared but the symbol table
+		RespCode Parse();
+		// Moves the module's declarations into the engine, resolves and compiles
+		RespCode Link();
+		void CreateOwnContext();
+
+		// Identifies the added sections in compiled files
+		uint64_t SourceHash() const;
 		public:
+		friend class Engine;
+		friend class ExecutionContext;
+
 		Module(Engine *engine, const std::string &name = "");
 
 		inline void SetName(const std::string &name_) { name = name_; }
 		inline const std::string &GetName() const { return name; }
 		
-		// Builds the AST
+		// Builds the AST and lowers it to bytecode
 		RespCode Build();
 
-		// Converts AST to scripting
+		// Runs the bytecode in the module's own context
 		RespCode Run();
+		// Contexts for other threads, built modules aren't modified while running
+		inline std::unique_ptr<ExecutionContext> CreateContext() const { return std::make_unique<ExecutionContext>(this); }
 
 		RespCode AddSectionFromFile(const std::string &file);
 		RespCode AddSectionFromMemory(const std::string &code);
 
+		// Writes the built module to 'file' so it can be loaded without parsing
+		RespCode SaveCompiled(const std::string &file) const;
+		// Loads a module saved by SaveCompiled instead of building it. The sections must still be added,
+		// fails if they changed since it was saved or it was saved by another version
+		RespCode LoadCompiled(const std::string &file);
+
+		// Writes the built module's functions as C++ to 'file', to be compiled into a shared library by the system compiler.
+		// Functions that only use primitives, locals, module level objects and each other are written, the rest stay in bytecode
+		RespCode Transpile(const std::string &file) const;
+		// Runs the functions of a library built from Transpile's output instead of their bytecode. Call it before running the module,
+		// fails if the sections changed since it was transpiled
+		RespCode LoadNative(const std::string &library);
+
+		// Resolves a built function once, fails if its parameters or return type can't be converted from/to the signature's.
+		// The handle runs in 'context', the module's own one if null
+		template<typename Signature>
+		Response<FunctionHandle<Signature>> GetFunction(const std::string &name, ExecutionContext *context = nullptr);
+
 		static RespCode CopyObjInto(ScriptObject *&dest, ScriptObject *src);
 	};
 
+	// Script function callable from C++ with primitive arguments, everything is looked up when it's created.
+	// Module level objects are initialized by ExecutionContext::Initialize or Run
+	template<typename R, typename... Args>
+	class FunctionHandle<R(Args...)> final {
+		static_assert((std::is_arithmetic_v<Args> && ...), "Function handles can only pass primitives");
+		static_assert(std::is_void_v<R> || std::is_arithmetic_v<R>, "Function handles can only return primitives or void");
+
+		ExecutionContext *context = nullptr;
+		ScriptFunc *func = nullptr;
+		std::array<Conversion, sizeof...(Args)> paramConversions{};	// From each argument to its parameter's type
+		Conversion returnConversion = nullptr;
+
+		public:
+		friend class Module;
+		using Result = std::conditional_t<std::is_void_v<R>, RespCode, Response<R>>;
+
+		FunctionHandle() = default;
+
+		inline bool IsValid() const { return func != nullptr; }
+		inline ScriptFunc *GetFunction() const { return func; }
+
+		Result operator()(Args... args) const {
+			auto fail = [] {
+				if constexpr (std::is_void_v<R>) return RespCode::ERR;
+				else return Response<R>(RespCode::ERR);
+			};
+
+			auto frame = context->NextFrame(func);
+			if (!frame) return fail();
+
+			size_t i = 0;
+			((paramConversions[i](&args, frame + func->GetParams()[i].offset), ++i), ...);
+
+			// Handles can be called from native functions while the stack is in use
+			auto &stack = context->callStack;
+			auto base = stack.size();
+			if (context->Enter(func, stack) != RespCode::SUCCESS) {
+				stack.erase(stack.begin() + base, stack.end());
+				return fail();
+			}
+
+			if constexpr (std::is_void_v<R>) {
+				stack.pop_back();
+				return RespCode::SUCCESS;
+			}
+			else {
+				R ret;
+				returnConversion(stack.back().data, &ret);
+				stack.pop_back();
+
+				return Response<R>(ret, RespCode::SUCCESS);
+			}
+		}
+	};
+
+	template<typename Signature>
+	Response<FunctionHandle<Signature>> Module::GetFunction(const std::string &name, ExecutionContext *context_) {
+		using Handle = FunctionHandle<Signature>;
+
+		auto func = FindFunction(name);
+		if (!func || !func->code || func->GetParamCount() != std::tuple_size_v<decltype(Handle::paramConversions)>) {
+			return Response<Handle>(RespCode::ERR);
+		}
+		if (!context_) context_ = context.get();
+		if (!context_ || context_->module != this) {
+			return Response<Handle>(RespCode::ERR);
+		}
+
+		Handle ret;
+		ret.context = context_;
+		ret.func = func;
+
+		bool valid = [&]<typename R, typename... Args>(R(*)(Args...)) {
+			size_t i = 0;
+			((ret.paramConversions[i] = GetConversion(KindOf<Args>(), func->GetParams()[i].type->Kind()), ++i), ...);
+
+			if constexpr (!std::is_void_v<R>) {
+				ret.returnConversion = GetConversion(func->returnType->Kind(), KindOf<R>());
+				if (!ret.returnConversion) return false;
+			}
+			return std::find(ret.paramConversions.begin(), ret.paramConversions.end(), nullptr) == ret.paramConversions.end();
+		}(static_cast<Signature *>(nullptr));
+
+		if (!valid) {
+			return Response<Handle>(RespCode::ERR);
+		}
+		return Response<Handle>(ret, RespCode::SUCCESS);
+	}
+
 	class Scope {
 		public:
 		enum class Type : int {
@@ -641,7 +1373,11 @@ namespace mlang {
 		std::vector<ScriptFunc *> funcs;
 		Engine *engine;
 		Scope *parent;
-		std::unique_ptr<ScriptRval> returnObj;
+
+		// Indices into the vectors above by interned name, methods are found through their class
+		std::unordered_map<Symbol, size_t> typeIndices;
+		std::unordered_map<Symbol, size_t> objectIndices;
+		std::unordered_map<Symbol, size_t> funcIndices;
 
 		public:
 		friend class Module;
@@ -665,11 +1401,16 @@ namespace mlang {
 		RespCode RegisterObject(ScriptObject *obj);
 		RespCode RegisterFunc(ScriptFunc *func);
 
-		Response<TypeInfo*> FindTypeInfoByName(const std::string &name) const;
+		Response<TypeInfo*> FindTypeInfoByName(std::string_view name) const;
+		Response<TypeInfo*> FindTypeInfo(Symbol name) const;
 		Response<TypeInfo*> FindTypeInfoByID(size_t id) const;
 
-		Response<ScriptObject*> FindObjectByName(const std::string &name) const;
-		Response<ScriptFunc *> FindFuncByName(const std::string &name) const;
+		Response<ScriptObject*> FindObjectByName(std::string_view name) const;
+		Response<ScriptObject*> FindObject(Symbol name) const;
+		// Index of the object in this scope only, parents aren't searched
+		Response<size_t> FindObjectSlot(Symbol name) const;
+		Response<ScriptFunc *> FindFuncByName(std::string_view name) const;
+		Response<ScriptFunc *> FindFunc(Symbol name) const;
 
 		void DebugPrint(int depth = 0) const;
 	};
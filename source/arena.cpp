@@ -0,0 +1,37 @@
+#include <marklang.h>
+
+namespace mlang {
+	void *Arena::Allocate(size_t size, size_t alignment) {
+		auto padding = (alignment - reinterpret_cast<uintptr_t>(curr) % alignment) % alignment;
+
+		if (!curr || padding + size > left) {
+			// Big requests get a block of their own so the current one keeps its free space
+			if (size + alignment > blockSize) {
+				auto ptr = reinterpret_cast<uintptr_t>(blocks.emplace_back(std::make_unique<char[]>(size + alignment)).get());
+				return reinterpret_cast<void *>((ptr + alignment - 1) / alignment * alignment);
+			}
+
+			curr = blocks.emplace_back(std::make_unique<char[]>(blockSize)).get();
+			left = blockSize;
+			padding = (alignment - reinterpret_cast<uintptr_t>(curr) % alignment) % alignment;
+		}
+
+		void *ret = curr + padding;
+		curr += padding + size;
+		left -= padding + size;
+
+		return ret;
+	}
+
+	void Arena::Reset() {
+		// Destroyed in reverse so nodes go before what they were built from
+		for (auto finalizer = finalizers.rbegin(); finalizer != finalizers.rend(); ++finalizer) {
+			finalizer->destroy(finalizer->obj);
+		}
+		finalizers.clear();
+
+		blocks.clear();
+		curr = nullptr;
+		left = 0;
+	}
+}
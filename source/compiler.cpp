@@ -0,0 +1,365 @@
+#include <marklang.h>
+#include <iostream>
+
+#ifndef __FUNCTION_NAME__
+	#if defined(WIN32) || defined(_WIN32)
+	#ifdef __PRETTY_FUNCTION__
+		#define __FUNCTION_NAME__  __PRETTY_FUNCTION__
+	#else
+		#define __FUNCTION_NAME__  __FUNCTION__
+	#endif
+#else
+	#define __FUNCTION_NAME__  __func__
+	#endif
+#endif
+
+namespace mlang {
+	static const std::unordered_map<Token::Type, OpCode> binaryOps = {
+		{ Token::Type::PLUS,	OpCode::ADD },
+		{ Token::Type::MINUS,	OpCode::SUB },
+		{ Token::Type::STAR,	OpCode::MUL },
+		{ Token::Type::SLASH,	OpCode::DIV },
+		{ Token::Type::LESS,	OpCode::LESS },
+		{ Token::Type::LEQ,		OpCode::LEQ },
+		{ Token::Type::GREATER,	OpCode::GREATER },
+		{ Token::Type::GEQ,		OpCode::GEQ },
+		{ Token::Type::EQ,		OpCode::EQ },
+		{ Token::Type::NEQ,		OpCode::NEQ },
+	};
+
+	static uint32_t Emit(Bytecode &code, OpCode op, uint32_t arg = 0, uint32_t arg2 = 0) {
+		code.code.push_back(Instruction{ op, arg, arg2 });
+		return static_cast<uint32_t>(code.code.size() - 1);
+	}
+	// Makes the jump at 'idx' land on the next emitted instruction
+	static void PatchJump(Bytecode &code, uint32_t idx) {
+		code.code[idx].arg = static_cast<uint32_t>(code.code.size());
+	}
+	// Emits 'op' on the binding, or a deferred error if it didn't resolve
+	static uint32_t EmitBound(Bytecode &code, OpCode op, const Binding &binding, uint32_t arg2 = 0) {
+		if (!binding.error.empty()) {
+			code.errors.push_back(binding.error);
+			return Emit(code, OpCode::FAIL, static_cast<uint32_t>(code.errors.size() - 1));
+		}
+
+		code.bindings.push_back(binding);
+		return Emit(code, op, static_cast<uint32_t>(code.bindings.size() - 1), arg2);
+	}
+
+	// Type a literal stored through 'binding' can be converted to ahead of time
+	static const TypeInfo *StoreType(const Binding &binding) {
+		if (!binding.error.empty() || !binding.type || binding.type->Kind() == NumericKind::NONE) return nullptr;
+
+		return binding.type;
+	}
+	// Type a literal passed as parameter 'idx' of the call bound by 'binding' can be converted to
+	static const TypeInfo *ParamType(const Binding &binding, size_t idx) {
+		if (!binding.error.empty() || !binding.func || idx >= binding.func->GetParams().size()) return nullptr;
+
+		auto type = binding.func->GetParams()[idx].type;
+		return (type->Kind() != NumericKind::NONE ? type : nullptr);
+	}
+	// 'value' converted to 'type' ahead of time like storing it would, unchanged without a type
+	static ScriptRval Converted(Engine *engine, ScriptRval &value, const TypeInfo *type) {
+		alignas(8) char bytes[sizeof(uint64_t)];
+		if (!type || type->Kind() == NumericKind::NONE || ScriptObject::StoreVal(type, bytes, value) != RespCode::SUCCESS) {
+			return value;
+		}
+
+		return ScriptRval::CreateFromMemory(engine, type, bytes);
+	}
+
+	std::optional<ScriptRval> Module::Fold(OpCode op, const ScriptRval &lhs, const ScriptRval &rhs) const {
+		NumericKind common;
+		if (!GetKernel(op, lhs.valueType->Kind(), rhs.valueType->Kind(), common)) return std::nullopt;
+
+		// Integer division by 0 fails and by -1 may wrap when it runs, neither is folded
+		if (op == OpCode::DIV && common != NumericKind::FLOAT && common != NumericKind::DOUBLE) {
+			int64_t divisor = 0;
+			GetConversion(rhs.valueType->Kind(), NumericKind::INT64)(rhs.data, &divisor);
+			if (divisor == 0 || divisor == -1) return std::nullopt;
+		}
+
+		switch (op) {
+			case OpCode::ADD: return lhs + rhs;
+			case OpCode::SUB: return lhs - rhs;
+			case OpCode::MUL: return lhs * rhs;
+			case OpCode::DIV: return lhs / rhs;
+			case OpCode::LESS: return lhs < rhs;
+			case OpCode::LEQ: return lhs <= rhs;
+			case OpCode::GREATER: return lhs > rhs;
+			case OpCode::GEQ: return lhs >= rhs;
+			case OpCode::EQ: return lhs == rhs;
+			case OpCode::NEQ: return lhs != rhs;
+			default: break;
+		}
+
+		return std::nullopt;
+	}
+
+	RespCode Module::CompileExpr(Bytecode &code, Expression *expr, const TypeInfo *as) {
+		if (!expr) return RespCode::ERR;
+
+		switch (expr->type) {
+			case Expression::Type::VALUE: {
+				auto casted = static_cast<ValueExpr *>(expr);
+
+				if (casted->val.type >= Token::Type::LITERALS_BEGIN && casted->val.type <= Token::Type::LITERALS_END) {
+					code.constants.push_back(ScriptRval::CreateFromLiteral(engine, casted->literal, as));
+					Emit(code, OpCode::PUSH_CONST, static_cast<uint32_t>(code.constants.size() - 1));
+					return RespCode::SUCCESS;
+				}
+				if (casted->val.type != Token::Type::IDENTIFIER) {
+					std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Invalid token " << casted->val.val << "\n";
+					return RespCode::ERR;
+				}
+
+				// Constant locals are pushed as their value
+				auto &binding = casted->binding;
+				if (binding.error.empty() && binding.kind == Binding::Kind::OBJECT && binding.isConst && binding.base == Binding::Base::FRAME) {
+					if (auto value = constLocals.find(binding.offset); value != constLocals.end() && value->second.valueType == binding.type) {
+						code.constants.push_back(Converted(engine, value->second, as));
+						Emit(code, OpCode::PUSH_CONST, static_cast<uint32_t>(code.constants.size() - 1));
+						return RespCode::SUCCESS;
+					}
+				}
+
+				EmitBound(code, OpCode::LOAD, casted->binding);
+				return RespCode::SUCCESS;
+			}
+			case Expression::Type::BINARY: {
+				auto casted = static_cast<BinaryExpr *>(expr);
+
+				auto op = binaryOps.find(casted->op.type);
+				if (op == binaryOps.end()) {
+					std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Invalid operator " << casted->op.val << "\n";
+					return RespCode::ERR;
+				}
+
+				auto start = code.code.size();
+				if (CompileExpr(code, casted->lhs) != RespCode::SUCCESS) return RespCode::ERR;
+				if (CompileExpr(code, casted->rhs) != RespCode::SUCCESS) return RespCode::ERR;
+
+				// Operands that compiled to the last two constants are replaced by the result, constant trees fold bottom-up in one pass
+				auto constants = code.constants.size();
+				if (code.code.size() == start + 2 && code.code[start].op == OpCode::PUSH_CONST && code.code[start + 1].op == OpCode::PUSH_CONST &&
+					code.code[start].arg + 2 == constants && code.code[start + 1].arg + 1 == constants) {
+					if (auto folded = Fold(op->second, code.constants[constants - 2], code.constants[constants - 1])) {
+						code.code.resize(start);
+						code.constants.erase(code.constants.end() - 2, code.constants.end());
+
+						code.constants.push_back(Converted(engine, *folded, as));
+						Emit(code, OpCode::PUSH_CONST, static_cast<uint32_t>(code.constants.size() - 1));
+						return RespCode::SUCCESS;
+					}
+				}
+
+				Emit(code, op->second);
+				return RespCode::SUCCESS;
+			}
+			case Expression::Type::FUNCCALL: {
+				auto casted = static_cast<FuncCallExpr *>(expr);
+
+				for (size_t i = 0; i < casted->params.size(); ++i) {
+					if (CompileExpr(code, casted->params[i], ParamType(casted->binding, i)) != RespCode::SUCCESS) return RespCode::ERR;
+				}
+
+				EmitBound(code, OpCode::CALL, casted->binding, static_cast<uint32_t>(casted->params.size()));
+				return RespCode::SUCCESS;
+			}
+			default:
+				break;
+		}
+
+		std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Unsupported expression\n";
+		return RespCode::ERR;
+	}
+
+	RespCode Module::CompileStmt(Bytecode &code, Statement *stmt) {
+		if (!stmt) return RespCode::SUCCESS;
+
+		switch (stmt->type) {
+			case Statement::Type::BLOCK: {
+				for (auto subStmt : static_cast<BlockStmt *>(stmt)->stmts) {
+					if (CompileStmt(code, subStmt) != RespCode::SUCCESS) return RespCode::ERR;
+				}
+				return RespCode::SUCCESS;
+			}
+			case Statement::Type::VARDECL: {
+				auto casted = static_cast<VarDeclStmt *>(stmt);
+
+				auto start = code.code.size();
+				if (casted->expr && CompileExpr(code, casted->expr, StoreType(casted->binding)) != RespCode::SUCCESS) return RespCode::ERR;
+
+				// A const local whose initializer compiled to one constant holds it for good, its frame offset is never given to another local
+				auto &binding = casted->binding;
+				if (binding.error.empty() && binding.base == Binding::Base::FRAME && binding.isConst && StoreType(binding) &&
+					code.code.size() == start + 1 && code.code[start].op == OpCode::PUSH_CONST) {
+					constLocals.emplace(binding.offset, Converted(engine, code.constants[code.code[start].arg], binding.type));
+				}
+
+				EmitBound(code, OpCode::DECLARE, binding, casted->expr ? 1 : 0);
+				return RespCode::SUCCESS;
+			}
+			case Statement::Type::ASSIGNEMENT: {
+				auto casted = static_cast<VarAssignStmt *>(stmt);
+
+				if (CompileExpr(code, casted->expr, StoreType(casted->binding)) != RespCode::SUCCESS) return RespCode::ERR;
+
+				EmitBound(code, OpCode::STORE, casted->binding);
+				return RespCode::SUCCESS;
+			}
+			case Statement::Type::FUNCCALL: {
+				auto casted = static_cast<FuncCallStmt *>(stmt);
+
+				for (size_t i = 0; i < casted->params.size(); ++i) {
+					if (CompileExpr(code, casted->params[i], ParamType(casted->binding, i)) != RespCode::SUCCESS) return RespCode::ERR;
+				}
+
+				EmitBound(code, OpCode::CALL, casted->binding, static_cast<uint32_t>(casted->params.size()));
+				Emit(code, OpCode::POP);
+				return RespCode::SUCCESS;
+			}
+			case Statement::Type::IF: {
+				auto casted = static_cast<IfStmt *>(stmt);
+
+				if (CompileExpr(code, casted->condition) != RespCode::SUCCESS) return RespCode::ERR;
+				auto jumpElse = Emit(code, OpCode::JUMP_IF_FALSE);
+
+				if (CompileStmt(code, casted->then) != RespCode::SUCCESS) return RespCode::ERR;
+
+				if (!casted->els) {
+					PatchJump(code, jumpElse);
+					return RespCode::SUCCESS;
+				}
+
+				auto jumpEnd = Emit(code, OpCode::JUMP);
+				PatchJump(code, jumpElse);
+
+				if (CompileStmt(code, casted->els) != RespCode::SUCCESS) return RespCode::ERR;
+
+				PatchJump(code, jumpEnd);
+				return RespCode::SUCCESS;
+			}
+			case Statement::Type::WHILE: {
+				auto casted = static_cast<WhileStmt *>(stmt);
+
+				auto begin = static_cast<uint32_t>(code.code.size());
+				if (CompileExpr(code, casted->cond) != RespCode::SUCCESS) return RespCode::ERR;
+				auto jumpEnd = Emit(code, OpCode::JUMP_IF_FALSE);
+
+				loopBreaks.emplace_back();
+				if (CompileStmt(code, casted->then) != RespCode::SUCCESS) return RespCode::ERR;
+				Emit(code, OpCode::JUMP, begin);
+
+				PatchJump(code, jumpEnd);
+				for (auto breakJump : loopBreaks.back()) {
+					PatchJump(code, breakJump);
+				}
+				loopBreaks.pop_back();
+
+				return RespCode::SUCCESS;
+			}
+			case Statement::Type::FOR: {
+				auto casted = static_cast<ForStmt *>(stmt);
+
+				if (CompileStmt(code, casted->start) != RespCode::SUCCESS) return RespCode::ERR;
+
+				auto begin = static_cast<uint32_t>(code.code.size());
+				if (CompileExpr(code, casted->cond) != RespCode::SUCCESS) return RespCode::ERR;
+				auto jumpEnd = Emit(code, OpCode::JUMP_IF_FALSE);
+
+				loopBreaks.emplace_back();
+				if (CompileStmt(code, casted->then) != RespCode::SUCCESS) return RespCode::ERR;
+				if (CompileStmt(code, casted->end) != RespCode::SUCCESS) return RespCode::ERR;
+				Emit(code, OpCode::JUMP, begin);
+
+				PatchJump(code, jumpEnd);
+				for (auto breakJump : loopBreaks.back()) {
+					PatchJump(code, breakJump);
+				}
+				loopBreaks.pop_back();
+
+				return RespCode::SUCCESS;
+			}
+			case Statement::Type::RETURN: {
+				auto casted = static_cast<ReturnStmt *>(stmt);
+
+				if (!currFunc) {
+					std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Return not in function\n";
+					return RespCode::ERR;
+				}
+				if (!casted->val) {
+					Emit(code, OpCode::RETURN_VOID);
+					return RespCode::SUCCESS;
+				}
+				if (currFunc->returnType == engine->GetPrimitive(Engine::Primitive::VOID)) {
+					std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Returning a value from void function '" << currFunc->GetName() << "'\n";
+					return RespCode::ERR;
+				}
+
+				auto returnType = (currFunc->returnType->Kind() != NumericKind::NONE ? currFunc->returnType : nullptr);
+				if (CompileExpr(code, casted->val, returnType) != RespCode::SUCCESS) return RespCode::ERR;
+				Emit(code, OpCode::RETURN);
+				return RespCode::SUCCESS;
+			}
+			case Statement::Type::BREAK: {
+				if (loopBreaks.empty()) {
+					std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Break not in loop\n";
+					return RespCode::ERR;
+				}
+
+				loopBreaks.back().push_back(Emit(code, OpCode::JUMP));
+				return RespCode::SUCCESS;
+			}
+			case Statement::Type::FUNCDEF:
+				// Functions are compiled on their own
+				return RespCode::SUCCESS;
+		}
+
+		return RespCode::ERR;
+	}
+
+	RespCode Module::CompileFunc(ScriptFunc *func) {
+		func->code = std::make_unique<Bytecode>();
+
+		currFunc = func;
+		loopBreaks.clear();
+		constLocals.clear();
+
+		auto retCode = CompileStmt(*func->code, func->func->block);
+		Emit(*func->code, OpCode::RETURN_VOID);
+
+		currFunc = nullptr;
+		return retCode;
+	}
+
+	RespCode Module::Compile() {
+		loopBreaks.clear();
+		constLocals.clear();
+
+		for (auto stmt : moduleStmts->stmts) {
+			if (CompileStmt(moduleCode, stmt) != RespCode::SUCCESS) {
+				return RespCode::ERR;
+			}
+		}
+		Emit(moduleCode, OpCode::HALT);
+
+		for (auto func : functions) {
+			if (CompileFunc(func) != RespCode::SUCCESS) {
+				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Error compiling function '" << func->GetName() << "'\n";
+				return RespCode::ERR;
+			}
+		}
+
+		// Inlining needs to know which callees run typed
+		for (auto func : functions) {
+			func->Optimize();
+		}
+		for (auto func : functions) {
+			Inline(func);
+		}
+
+		return RespCode::SUCCESS;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#include <marklang.h>
+#include <utility>
+
+namespace mlang {
+	template<size_t I>
+	static constexpr Conversion MakeConversion() {
+		constexpr auto from = static_cast<NumericKind>(I / numericKindCount);
+		constexpr auto to = static_cast<NumericKind>(I % numericKindCount);
+
+		if constexpr (from == NumericKind::NONE || to == NumericKind::NONE) {
+			return nullptr;
+		}
+		else {
+			return &Convert<from, to>;
+		}
+	}
+	template<size_t... I>
+	static constexpr std::array<Conversion, sizeof...(I)> MakeConversions(std::index_sequence<I...>) {
+		return { MakeConversion<I>()... };
+	}
+
+	const std::array<Conversion, numericKindCount * numericKindCount> conversions = MakeConversions(std::make_index_sequence<numericKindCount * numericKindCount>());
+}
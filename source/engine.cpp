@@ -1,4 +1,6 @@
 #include <iostream>
+#include <thread>
+#include <atomic>
 #include <marklang.h>
 
 namespace mlang {
@@ -7,23 +9,35 @@ namespace mlang {
 		currScope = globalScope;
 
 		// Deals with primitives
-		globalScope->RegisterType(new TypeInfo(this, GenerateTID(), "void", 0));
+		AddPrimitive("void", 0, NumericKind::NONE);
 
-		globalScope->RegisterType(new TypeInfo(this, GenerateTID(), "bool", 1));
-		globalScope->RegisterType(new TypeInfo(this, GenerateTID(), "char", 1));
-		globalScope->RegisterType(new TypeInfo(this, GenerateTID(), "short", 2));
-		globalScope->RegisterType(new TypeInfo(this, GenerateTID(), "int", 4));
-		globalScope->RegisterType(new TypeInfo(this, GenerateTID(), "long", 8));
+		AddPrimitive("bool", 1, NumericKind::BOOL);
+		AddPrimitive("char", 1, NumericKind::INT8);
+		AddPrimitive("short", 2, NumericKind::INT16);
+		AddPrimitive("int", 4, NumericKind::INT32);
+		AddPrimitive("long", 8, NumericKind::INT64);
 
-		globalScope->RegisterType(new TypeInfo(this, GenerateTID(), "unsigned char", 1, true));
-		globalScope->RegisterType(new TypeInfo(this, GenerateTID(), "unsigned short", 2, true));
-		globalScope->RegisterType(new TypeInfo(this, GenerateTID(), "unsigned int", 4, true));
-		globalScope->RegisterType(new TypeInfo(this, GenerateTID(), "unsigned long", 8, true));
+		AddPrimitive("unsigned char", 1, NumericKind::UINT8, true);
+		AddPrimitive("unsigned short", 2, NumericKind::UINT16, true);
+		AddPrimitive("unsigned int", 4, NumericKind::UINT32, true);
+		AddPrimitive("unsigned long", 8, NumericKind::UINT64, true);
 
-		globalScope->RegisterType(new TypeInfo(this, GenerateTID(), "float", 4));
-		globalScope->RegisterType(new TypeInfo(this, GenerateTID(), "double", 8));
+		AddPrimitive("float", 4, NumericKind::FLOAT);
+		AddPrimitive("double", 8, NumericKind::DOUBLE);
+
+		assert(typeTable.size() == static_cast<size_t>(Primitive::COUNT));
+	}
+	void Engine::AddPrimitive(const std::string &name, size_t size, NumericKind kind, bool isUnsigned) {
+		auto type = RegisterTypeID(new TypeInfo(this, 0, name, size, isUnsigned));
+		type->kind = kind;
+
+		// The kind doubles as the index of the primitive
+		assert(type->TypeID() == static_cast<size_t>(kind) || kind == NumericKind::NONE);
+		globalScope->RegisterType(type);
 	}
 	Engine::~Engine() {
+		// Modules hold values referencing the global types
+		modules.clear();
 		delete globalScope;
 	}
 
@@ -56,6 +70,51 @@ namespace mlang {
 		return RespCode::SUCCESS;
 	}
 
+	RespCode Engine::BuildModules(const std::vector<std::string> &names, size_t threadCount) {
+		std::vector<Module *> toBuild;
+		for (auto &name : names) {
+			auto module = GetModule(name);
+			if (module.code != RespCode::SUCCESS) {
+				return RespCode::ERR;
+			}
+			toBuild.push_back(module.data.value());
+		}
+
+		if (!threadCount) {
+			threadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		}
+		threadCount = std::min(threadCount, toBuild.size());
+
+		// Parsing only reads the engine, each worker takes the next module left
+		std::vector<RespCode> parsed(toBuild.size(), RespCode::ERR);
+		std::atomic<size_t> next = 0;
+		auto parse = [&]() {
+			for (size_t i; (i = next++) < toBuild.size();) {
+				parsed[i] = toBuild[i]->Parse();
+			}
+		};
+
+		std::vector<std::thread> workers;
+		for (size_t i = 1; i < threadCount; ++i) {
+			workers.emplace_back(parse);
+		}
+		parse();
+		for (auto &worker : workers) {
+			worker.join();
+		}
+
+		// Linking changes the global scope, modules are linked in the order they were given
+		auto ret = RespCode::SUCCESS;
+		for (size_t i = 0; i < toBuild.size(); ++i) {
+			if (parsed[i] != RespCode::SUCCESS || toBuild[i]->Link() != RespCode::SUCCESS) {
+				std::cout << "Module '" << toBuild[i]->GetName() << "' failed to build\n";
+				ret = RespCode::ERR;
+			}
+		}
+
+		return ret;
+	}
+
 	Scope *Engine::GetScope() const {
 		return currScope;
 	}
@@ -68,9 +127,33 @@ namespace mlang {
 			return RespCode::ERR;
 		}
 
-		globalScope->RegisterType(new TypeInfo(this, GenerateTID(), name, size, false, offset, classInfo, isClass));
+		globalScope->RegisterType(RegisterTypeID(new TypeInfo(this, 0, name, size, false, offset, classInfo, isClass)));
 		return RespCode::SUCCESS;
 	}
+	RespCode Engine::RegisterNative(const std::string &name, NativeThunk thunk, std::shared_ptr<void> target, TypeInfo *returnType, std::vector<TypeInfo *> &&paramTypes, const size_t *paramOffsets) {
+		if (globalScope->FindFuncByName(name).code == RespCode::SUCCESS) {
+			std::cout << "Function '" << name << "' already exists\n";
+			return RespCode::ERR;
+		}
+
+		auto func = new ScriptFunc(name, paramTypes.size(), nullptr, returnType);
+		func->native = thunk;
+		func->nativeTarget = std::move(target);
+
+		for (size_t i = 0; i < paramTypes.size(); ++i) {
+			func->params.push_back(ScriptFunc::Param{ paramTypes[i], paramOffsets[i] });
+			func->frameSize = std::max(func->frameSize, paramOffsets[i] + paramTypes[i]->Size());
+		}
+		func->frameSize = (func->frameSize + 7) / 8 * 8;
+
+		return globalScope->RegisterFunc(func);
+	}
+	TypeInfo *Engine::RegisterTypeID(TypeInfo *type) {
+		type->typeID = typeTable.size();
+		typeTable.push_back(type);
+
+		return type;
+	}
 	Response<size_t> Engine::GetTypeIdxByName(const std::string &name) const {
 		auto data = globalScope->FindTypeInfoByName(name).data;
 		if (!data) {
@@ -79,7 +162,7 @@ namespace mlang {
 		return Response<size_t>(data.value()->TypeID(), RespCode::SUCCESS);
 	}
 	TypeInfo *Engine::GetTypeInfoByIdx(size_t idx) const {
-		return globalScope->FindTypeInfoByID(idx).data.value();
+		return (idx < typeTable.size() ? typeTable[idx] : nullptr);
 	}
 	TypeInfo *Engine::GetTypeInfoByName(const std::string &name) const {
 		return globalScope->FindTypeInfoByName(name).data.value();
@@ -0,0 +1,388 @@
+#include <marklang.h>
+#include <cstring>
+
+#if defined(WIN32) || defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+	#define MLANG_JIT
+#endif
+
+namespace mlang {
+	JitCode::~JitCode() {
+		if (!memory) return;
+
+#if defined(WIN32) || defined(_WIN32)
+		VirtualFree(memory, 0, MEM_RELEASE);
+#else
+		munmap(memory, size);
+#endif
+	}
+
+#ifdef MLANG_JIT
+	// Register numbers as encoded, the code only uses registers both calling conventions leave to the callee
+	enum Reg : uint8_t {
+		RAX = 0, RCX = 1, RDX = 2, RSI = 6, RDI = 7, R8 = 8, R9 = 9, R10 = 10, R11 = 11
+	};
+#if defined(WIN32) || defined(_WIN32)
+	static constexpr Reg frameReg = RCX, slotsReg = RDX, retReg = R8, globalsReg = R9;
+#else
+	static constexpr Reg frameReg = RDI, slotsReg = RSI, retReg = RDX, globalsReg = RCX;
+#endif
+
+	// Integers are kept sign extended in rax, the other operand in r10. Floating values in xmm0 and xmm1
+	class Assembler {
+		std::vector<uint8_t> code;
+		std::vector<std::pair<uint32_t, uint32_t>> jumps;	// Offset of a rel32 and the instruction it goes to
+
+		void Byte(uint8_t byte) { code.push_back(byte); }
+		void Bytes(std::initializer_list<uint8_t> bytes) { code.insert(code.end(), bytes); }
+		void Dword(uint32_t value) {
+			for (int i = 0; i < 4; ++i) Byte(static_cast<uint8_t>(value >> (i * 8)));
+		}
+		// [prefix] [REX] 0F? op modrm disp32 for 'reg' and [base + disp]
+		void Memory(uint8_t prefix, bool wide, std::initializer_list<uint8_t> op, uint8_t reg, Reg base, int32_t disp) {
+			if (prefix) Byte(prefix);
+
+			uint8_t rex = 0x40 | (wide ? 0x08 : 0) | ((reg & 8) ? 0x04 : 0) | ((base & 8) ? 0x01 : 0);
+			if (rex != 0x40) Byte(rex);
+
+			Bytes(op);
+			Byte(0x80 | ((reg & 7) << 3) | (base & 7));
+			Dword(static_cast<uint32_t>(disp));
+		}
+
+		public:
+		inline uint32_t Offset() const { return static_cast<uint32_t>(code.size()); }
+		inline const std::vector<uint8_t> &Code() const { return code; }
+
+		void Load(NumericKind kind, Reg base, int32_t disp) {
+			switch (kind) {
+				case NumericKind::BOOL: Memory(0, false, { 0x0f, 0xb6 }, RAX, base, disp); break;	// movzx eax, byte
+				case NumericKind::INT32: Memory(0, true, { 0x63 }, RAX, base, disp); break;			// movsxd rax
+				case NumericKind::INT64: Memory(0, true, { 0x8b }, RAX, base, disp); break;			// mov rax
+				case NumericKind::FLOAT: Memory(0xf3, false, { 0x0f, 0x10 }, 0, base, disp); break;	// movss xmm0
+				case NumericKind::DOUBLE: Memory(0xf2, false, { 0x0f, 0x10 }, 0, base, disp); break;	// movsd xmm0
+				default: break;
+			}
+		}
+		void Store(NumericKind kind, Reg base, int32_t disp) {
+			switch (kind) {
+				case NumericKind::BOOL: Memory(0, false, { 0x88 }, RAX, base, disp); break;			// mov byte, al
+				case NumericKind::INT32: Memory(0, false, { 0x89 }, RAX, base, disp); break;			// mov dword, eax
+				case NumericKind::INT64: Memory(0, true, { 0x89 }, RAX, base, disp); break;			// mov qword, rax
+				case NumericKind::FLOAT: Memory(0xf3, false, { 0x0f, 0x11 }, 0, base, disp); break;	// movss
+				case NumericKind::DOUBLE: Memory(0xf2, false, { 0x0f, 0x11 }, 0, base, disp); break;	// movsd
+				default: break;
+			}
+		}
+		// Same bits as a primitive of 'kind', zeroed
+		void StoreZero(NumericKind kind, Reg base, int32_t disp) {
+			Bytes({ 0x31, 0xc0 });	// xor eax, eax
+			switch (kind) {
+				case NumericKind::FLOAT: Store(NumericKind::INT32, base, disp); break;
+				case NumericKind::DOUBLE: Store(NumericKind::INT64, base, disp); break;
+				default: Store(kind, base, disp); break;
+			}
+		}
+		void LoadBits(uint64_t bits) {
+			Bytes({ 0x48, 0xb8 });	// mov rax, imm64
+			Dword(static_cast<uint32_t>(bits));
+			Dword(static_cast<uint32_t>(bits >> 32));
+		}
+
+		// Like a C cast of the value in rax or xmm0
+		void Convert(NumericKind from, NumericKind to) {
+			bool fromFloat = (from == NumericKind::FLOAT || from == NumericKind::DOUBLE);
+			if (from == to) return;
+
+			if (to == NumericKind::BOOL) {
+				if (!fromFloat) {
+					Bytes({ 0x48, 0x85, 0xc0 });	// test rax, rax
+					Bytes({ 0x0f, 0x95, 0xc0 });	// setne al
+				}
+				else {
+					// NaN is true as well
+					Bytes({ 0x0f, 0x57, 0xc9 });	// xorps xmm1, xmm1
+					if (from == NumericKind::DOUBLE) Byte(0x66);
+					Bytes({ 0x0f, 0x2e, 0xc1 });	// ucomiss/ucomisd xmm0, xmm1
+					Bytes({ 0x0f, 0x95, 0xc0 });	// setne al
+					Bytes({ 0x41, 0x0f, 0x9a, 0xc3 });	// setp r11b
+					Bytes({ 0x44, 0x08, 0xd8 });	// or al, r11b
+				}
+				Bytes({ 0x0f, 0xb6, 0xc0 });	// movzx eax, al
+				return;
+			}
+
+			switch (to) {
+				case NumericKind::INT32:
+				case NumericKind::INT64:
+					if (fromFloat) {
+						// cvttss2si/cvttsd2si
+						Bytes({ static_cast<uint8_t>(from == NumericKind::FLOAT ? 0xf3 : 0xf2), static_cast<uint8_t>(to == NumericKind::INT64 ? 0x48 : 0x40), 0x0f, 0x2c, 0xc0 });
+					}
+					if (to == NumericKind::INT32) Bytes({ 0x48, 0x63, 0xc0 });	// movsxd rax, eax
+					break;
+				case NumericKind::FLOAT:
+				case NumericKind::DOUBLE:
+					if (!fromFloat) {
+						// cvtsi2ss/cvtsi2sd xmm0, rax
+						Bytes({ static_cast<uint8_t>(to == NumericKind::FLOAT ? 0xf3 : 0xf2), 0x48, 0x0f, 0x2a, 0xc0 });
+					}
+					else {
+						// cvtss2sd/cvtsd2ss
+						Bytes({ static_cast<uint8_t>(from == NumericKind::FLOAT ? 0xf3 : 0xf2), 0x0f, 0x5a, 0xc0 });
+					}
+					break;
+				default:
+					break;
+			}
+		}
+		// Moves the first operand out of the way of the second
+		void Hold(NumericKind kind) {
+			if (kind == NumericKind::FLOAT || kind == NumericKind::DOUBLE) Bytes({ 0x0f, 0x28, 0xc8 });	// movaps xmm1, xmm0
+			else Bytes({ 0x49, 0x89, 0xc2 });	// mov r10, rax
+		}
+		// rax/xmm0 = rax/xmm0 op r10/xmm1, comparisons leave a bool
+		bool Compute(OpCode op, NumericKind kind) {
+			if (kind == NumericKind::FLOAT || kind == NumericKind::DOUBLE) {
+				uint8_t prefix = (kind == NumericKind::FLOAT ? 0xf3 : 0xf2);
+				uint8_t compare = (kind == NumericKind::FLOAT ? 0 : 0x66);
+				auto ucomis = [&](uint8_t modrm) {
+					if (compare) Byte(compare);
+					Bytes({ 0x0f, 0x2e, modrm });
+				};
+
+				switch (op) {
+					case OpCode::ADD: Bytes({ prefix, 0x0f, 0x58, 0xc1 }); return true;
+					case OpCode::SUB: Bytes({ prefix, 0x0f, 0x5c, 0xc1 }); return true;
+					case OpCode::MUL: Bytes({ prefix, 0x0f, 0x59, 0xc1 }); return true;
+					case OpCode::DIV: Bytes({ prefix, 0x0f, 0x5e, 0xc1 }); return true;
+					// Unordered operands compare false
+					case OpCode::LESS: ucomis(0xc8); Bytes({ 0x0f, 0x97, 0xc0 }); break;		// ucomis xmm1, xmm0; seta
+					case OpCode::LEQ: ucomis(0xc8); Bytes({ 0x0f, 0x93, 0xc0 }); break;		// ucomis xmm1, xmm0; setae
+					case OpCode::GREATER: ucomis(0xc1); Bytes({ 0x0f, 0x97, 0xc0 }); break;	// ucomis xmm0, xmm1; seta
+					case OpCode::GEQ: ucomis(0xc1); Bytes({ 0x0f, 0x93, 0xc0 }); break;		// ucomis xmm0, xmm1; setae
+					case OpCode::EQ:
+						ucomis(0xc1);
+						Bytes({ 0x0f, 0x94, 0xc0, 0x41, 0x0f, 0x9b, 0xc3, 0x44, 0x20, 0xd8 });	// sete al; setnp r11b; and al, r11b
+						break;
+					case OpCode::NEQ:
+						ucomis(0xc1);
+						Bytes({ 0x0f, 0x95, 0xc0, 0x41, 0x0f, 0x9a, 0xc3, 0x44, 0x08, 0xd8 });	// setne al; setp r11b; or al, r11b
+						break;
+					default: return false;
+				}
+				Bytes({ 0x0f, 0xb6, 0xc0 });	// movzx eax, al
+				return true;
+			}
+
+			// Integer division throws on zero, it stays with the interpreter
+			uint8_t rex = (kind == NumericKind::INT64 ? 0x4c : 0x44);
+			uint8_t setcc = 0;
+			switch (op) {
+				case OpCode::ADD: Bytes({ rex, 0x01, 0xd0 }); break;	// add rax, r10
+				case OpCode::SUB: Bytes({ rex, 0x29, 0xd0 }); break;	// sub rax, r10
+				case OpCode::MUL: Bytes({ static_cast<uint8_t>(rex == 0x4c ? 0x49 : 0x41), 0x0f, 0xaf, 0xc2 }); break;	// imul rax, r10
+				case OpCode::LESS: setcc = 0x9c; break;
+				case OpCode::LEQ: setcc = 0x9e; break;
+				case OpCode::GREATER: setcc = 0x9f; break;
+				case OpCode::GEQ: setcc = 0x9d; break;
+				case OpCode::EQ: setcc = 0x94; break;
+				case OpCode::NEQ: setcc = 0x95; break;
+				default: return false;
+			}
+
+			if (setcc) {
+				Bytes({ rex, 0x39, 0xd0 });		// cmp rax, r10
+				Bytes({ 0x0f, setcc, 0xc0 });	// setcc al
+				Bytes({ 0x0f, 0xb6, 0xc0 });	// movzx eax, al
+			}
+			else if (kind == NumericKind::INT32) {
+				Bytes({ 0x48, 0x63, 0xc0 });	// movsxd rax, eax
+			}
+			return true;
+		}
+
+		void Jump(uint32_t target) {
+			Byte(0xe9);
+			jumps.emplace_back(Offset(), target);
+			Dword(0);
+		}
+		// Jumps if eax is 0
+		void JumpIfZero(uint32_t target) {
+			Bytes({ 0x85, 0xc0, 0x0f, 0x84 });	// test eax, eax; jz
+			jumps.emplace_back(Offset(), target);
+			Dword(0);
+		}
+		void Return(bool wroteValue) {
+			if (wroteValue) Bytes({ 0xb8, 0x01, 0x00, 0x00, 0x00 });	// mov eax, 1
+			else Bytes({ 0x31, 0xc0 });	// xor eax, eax
+			Byte(0xc3);
+		}
+
+		void PatchJumps(const std::vector<uint32_t> &entries) {
+			for (auto [offset, target] : jumps) {
+				auto rel = static_cast<int32_t>(entries[target]) - static_cast<int32_t>(offset + 4);
+				std::memcpy(&code[offset], &rel, sizeof(rel));
+			}
+		}
+	};
+
+	static bool Supported(NumericKind kind) {
+		return kind == NumericKind::BOOL || kind == NumericKind::INT32 || kind == NumericKind::INT64 || kind == NumericKind::FLOAT || kind == NumericKind::DOUBLE;
+	}
+	// Same promotion as the interpreter's kernels, for the supported kinds
+	static NumericKind Common(NumericKind lhs, NumericKind rhs) {
+		if (lhs == NumericKind::DOUBLE || rhs == NumericKind::DOUBLE) return NumericKind::DOUBLE;
+		if (lhs == NumericKind::FLOAT || rhs == NumericKind::FLOAT) return NumericKind::FLOAT;
+		if (lhs == NumericKind::INT64 || rhs == NumericKind::INT64) return NumericKind::INT64;
+		return NumericKind::INT32;
+	}
+#endif
+
+	std::unique_ptr<JitCode> JitCode::Compile(const OptimizedCode &code) {
+#ifndef MLANG_JIT
+		return nullptr;
+#else
+		Assembler as;
+		std::vector<uint32_t> entries(code.code.size());
+
+		// Where a binding's storage is, false if it's out of reach. Other modules' objects are in each context's copy
+		auto locate = [](const Binding &binding, Reg &base, int32_t &disp) {
+			switch (binding.base) {
+				case Binding::Base::FRAME: base = frameReg; break;
+				case Binding::Base::GLOBAL: base = globalsReg; break;
+				default:
+					return false;
+			}
+
+			disp = static_cast<int32_t>(binding.offset);
+			return true;
+		};
+		auto slot = [](uint32_t idx) { return static_cast<int32_t>(idx * sizeof(uint64_t)); };
+
+		for (size_t i = 0; i < code.code.size(); ++i) {
+			auto &inst = code.code[i];
+			entries[i] = as.Offset();
+
+			Reg base = frameReg;
+			int32_t disp = 0;
+			switch (inst.op) {
+				case TypedOp::CONST:
+					as.LoadBits(code.constants[inst.arg]);
+					as.Store(NumericKind::INT64, slotsReg, slot(inst.slot));
+					break;
+				case TypedOp::LOAD_FRAME:
+				case TypedOp::LOAD:
+					if (!Supported(inst.kind)) return nullptr;
+
+					if (inst.op == TypedOp::LOAD_FRAME) {
+						base = frameReg;
+						disp = static_cast<int32_t>(inst.arg);
+					}
+					else if (!locate(code.source->bindings[inst.arg], base, disp)) {
+						return nullptr;
+					}
+
+					as.Load(inst.kind, base, disp);
+					as.Store(inst.kind, slotsReg, slot(inst.slot));
+					break;
+				case TypedOp::STORE_FRAME:
+				case TypedOp::STORE:
+					if (!Supported(inst.kind) || !Supported(inst.from)) return nullptr;
+
+					as.Load(inst.from, slotsReg, slot(inst.slot));
+					as.Convert(inst.from, inst.kind);
+					if (inst.op == TypedOp::STORE_FRAME) {
+						base = frameReg;
+						disp = static_cast<int32_t>(inst.arg);
+					}
+					else if (!locate(code.source->bindings[inst.arg], base, disp)) {
+						return nullptr;
+					}
+
+					as.Store(inst.kind, base, disp);
+					break;
+				case TypedOp::ZERO:
+					if (!Supported(inst.kind) || !locate(code.source->bindings[inst.arg], base, disp)) return nullptr;
+
+					as.StoreZero(inst.kind, base, disp);
+					break;
+				case TypedOp::COMPUTE: {
+					if (!Supported(inst.from) || !Supported(inst.fromArg)) return nullptr;
+
+					auto common = Common(inst.from, inst.fromArg);
+					as.Load(inst.fromArg, slotsReg, slot(inst.arg));
+					as.Convert(inst.fromArg, common);
+					as.Hold(common);
+					as.Load(inst.from, slotsReg, slot(inst.slot));
+					as.Convert(inst.from, common);
+
+					if (!as.Compute(code.source->code[i].op, common)) return nullptr;
+					as.Store(inst.kind, slotsReg, slot(inst.slot));
+					break;
+				}
+
+				case TypedOp::JUMP:
+				case TypedOp::LOOP:
+					as.Jump(inst.arg);
+					break;
+				case TypedOp::JUMP_IF_FALSE:
+					if (!Supported(inst.from)) return nullptr;
+
+					as.Load(inst.from, slotsReg, slot(inst.slot));
+					as.Convert(inst.from, NumericKind::BOOL);
+					as.JumpIfZero(inst.arg);
+					break;
+				case TypedOp::RETURN:
+					if (!Supported(inst.kind) || !Supported(inst.from)) return nullptr;
+
+					as.Load(inst.from, slotsReg, slot(inst.slot));
+					as.Convert(inst.from, inst.kind);
+					as.Store(inst.kind, retReg, 0);
+					as.Return(true);
+					break;
+				case TypedOp::RETURN_VOID:
+					as.Return(false);
+					break;
+				case TypedOp::NOP:
+					break;
+				default:
+					// Calls and errors need the interpreter
+					return nullptr;
+			}
+		}
+		as.PatchJumps(entries);
+
+		auto ret = std::make_unique<JitCode>();
+		ret->size = as.Code().size();
+		ret->entries = std::move(entries);
+
+		// Written while writable, then made executable
+#if defined(WIN32) || defined(_WIN32)
+		ret->memory = VirtualAlloc(nullptr, ret->size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+		if (!ret->memory) return nullptr;
+
+		std::memcpy(ret->memory, as.Code().data(), ret->size);
+		DWORD oldProtect;
+		if (!VirtualProtect(ret->memory, ret->size, PAGE_EXECUTE_READ, &oldProtect)) return nullptr;
+		FlushInstructionCache(GetCurrentProcess(), ret->memory, ret->size);
+#else
+		void *memory = mmap(nullptr, ret->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (memory == MAP_FAILED) return nullptr;
+		ret->memory = memory;
+
+		std::memcpy(ret->memory, as.Code().data(), ret->size);
+		if (mprotect(ret->memory, ret->size, PROT_READ | PROT_EXEC) != 0) return nullptr;
+#endif
+
+		return ret;
+#endif
+	}
+}
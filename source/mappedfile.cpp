@@ -0,0 +1,80 @@
+#include <marklang.h>
+
+#if defined(WIN32) || defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace mlang {
+	RespCode MappedFile::Open(const std::string &path) {
+		Close();
+
+#if defined(WIN32) || defined(_WIN32)
+		HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) return RespCode::ERR;
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize)) {
+			CloseHandle(file);
+			return RespCode::ERR;
+		}
+
+		// Empty files can't be mapped, they're just empty views
+		if (fileSize.QuadPart) {
+			HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mapping) {
+				CloseHandle(file);
+				return RespCode::ERR;
+			}
+
+			data = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+
+		if (fileSize.QuadPart && !data) return RespCode::ERR;
+		size = static_cast<size_t>(fileSize.QuadPart);
+#else
+		int file = open(path.c_str(), O_RDONLY);
+		if (file < 0) return RespCode::ERR;
+
+		struct stat info;
+		if (fstat(file, &info) != 0) {
+			close(file);
+			return RespCode::ERR;
+		}
+
+		// Empty files can't be mapped, they're just empty views
+		if (info.st_size) {
+			void *mapped = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+			if (mapped == MAP_FAILED) {
+				close(file);
+				return RespCode::ERR;
+			}
+			data = static_cast<const char *>(mapped);
+		}
+		close(file);
+
+		size = static_cast<size_t>(info.st_size);
+#endif
+		return RespCode::SUCCESS;
+	}
+	void MappedFile::Close() {
+		if (data) {
+#if defined(WIN32) || defined(_WIN32)
+			UnmapViewOfFile(data);
+#else
+			munmap(const_cast<char *>(data), size);
+#endif
+		}
+
+		data = nullptr;
+		size = 0;
+	}
+}
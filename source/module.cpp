@@ -1,6 +1,5 @@
 #include <marklang.h>
 #include <iostream>
-#include <fstream>
 #include <filesystem>
 #include <cstring>
 #include <cassert>
@@ -35,9 +34,15 @@ namespace mlang {
 			return RespCode::ERR;
 		}
 
-		std::ifstream fp(file);
-		tokenizer.AddCode(std::string(std::istreambuf_iterator<char>(fp), {}));
-		fp.close();
+		// Tokenized in place, the mapping lives as long as the module
+		auto mapped = std::make_unique<MappedFile>();
+		if (mapped->Open(file) != RespCode::SUCCESS) {
+			std::cout << "File '" << std::filesystem::absolute(file) << "' couldn't be opened\n";
+			return RespCode::ERR;
+		}
+
+		tokenizer.AddSection(mapped->View());
+		tokenizer.files.push_back(std::move(mapped));
 
 		return RespCode::SUCCESS;
 	}
@@ -46,122 +51,13 @@ namespace mlang {
 			std::cout << "Code is empty\n";
 			return RespCode::ERR;
 		}
-		tokenizer.AddCode(inCode);
+		tokenizer.AddSection(tokenizer.memorySections.emplace_back(inCode));
 
 		return RespCode::SUCCESS;
 	}
 
 	Module::Module(Engine *engine_, const std::string &name_)
-		:engine(engine_), name(name_), moduleStmts(std::make_unique<BlockStmt>()) {}
-
-	std::optional<std::variant<ScriptFunc *, ScriptObject *>> Module::NameResolution(const std::string &name, Scope *scope) {
-		if(!scope)
-			scope = engine->GetScope();
-
-		if (name.find(':') == std::string::npos && name.find('.') == std::string::npos) {
-			if (scope->FindObjectByName(name).data.value()) {
-				return scope->FindObjectByName(name).data.value();
-			}
-			else if (scope->FindFuncByName(name).data.value()) {
-				auto func = scope->FindFuncByName(name).data.value();
-				if (func->isMethod) {
-					func->object = scope->parentFunc->object;
-				}
-				return func;
-			}
-
-			// Class name resolution
-			if (scope->parentFunc && scope->IsOfType(Scope::Type::CLASS)) {
-				if (scope->parentFunc->GetScriptObject() && scope->parentFunc->GetScriptObject()->GetMember(name)) {
-					return scope->parentFunc->GetScriptObject()->GetMember(name);
-				}
-				else if (scope->parentFunc->GetScriptObject() && scope->parentFunc->GetScriptObject()->GetType()->GetMethod(name)) {
-					auto method = scope->parentFunc->GetScriptObject()->GetType()->GetMethod(name);
-					if (method)
-						method.value()->object = scope->parentFunc->GetScriptObject();
-					return method;
-				}
-				
-			}
-			return std::nullopt;
-		}
-
-		std::vector<std::string> ret;
-		size_t pos, last = 0;
-
-		std::optional<std::variant<ScriptFunc *, ScriptObject *>> tmp;
-
-		while ((pos = name.find_first_of(".:", last)) != std::string::npos) {
-			if (name[pos] == ':' && name[pos + 1] != ':') {
-				return std::nullopt;
-			}
-			else if (name[pos] == ':') pos++;
-
-			if (pos > last) {
-				auto word = name.substr(last, pos - last);
-				if (tmp && std::holds_alternative<ScriptObject*>(tmp.value())) {
-					auto object = std::get<ScriptObject *>(tmp.value());
-					if (object->GetMember(word)) {
-						tmp = object->GetMember(word);
-					}
-					else if (object->GetType()->GetMethod(word)) {
-						tmp = object->GetType()->GetMethod(word);
-						if (tmp) {
-							std::get<ScriptFunc *>(tmp.value())->SetClassObject(object);
-							std::get<ScriptFunc *>(tmp.value())->func->funcScope->parentFunc = std::get<ScriptFunc *>(tmp.value());
-						}
-					}
-					else if (scope->parentFunc && scope->IsOfType(Scope::Type::CLASS)) {
-						auto obj = scope->parentFunc->GetScriptObject();
-						if (!obj) {
-							return std::nullopt;
-						}
-
-						tmp = obj->GetMember(word);
-					}
-					else {
-						return std::nullopt;
-					}
-				}
-				else {
-					if (scope->FindFuncByName(word).data.value()) {
-						tmp = (scope->FindFuncByName(word).data.value());
-					}
-					else if (scope->FindObjectByName(word).data.value()) {
-						tmp = scope->FindObjectByName(word).data.value();
-					}
-					else if (scope->IsOfType(Scope::Type::CLASS) && scope->parentFunc->object->GetMember(word)) {
-						tmp = scope->parentFunc->object->GetMember(word).value();
-					}
-					else {
-						return std::nullopt;
-					}
-				}
-			}
-
-			last = pos + 2;
-		}
-		if (last < name.length() && std::holds_alternative<ScriptObject *>(tmp.value())) {
-			if (last) last--;
-			std::string word = name.substr(last, std::string::npos);
-
-			auto object = std::get<ScriptObject *>(tmp.value());
-			if (object->GetMember(word)) {
-				tmp = object->GetMember(word);
-			}
-			else if (object->GetType()->GetMethod(word)) {
-				tmp = object->GetType()->GetMethod(word);
-				auto func = std::get<ScriptFunc *>(tmp.value());
-				func->SetClassObject(object);
-				func->func->funcScope->parentFunc = func;
-			}
-			else {
-				return std::nullopt;
-			}
-		}
-
-		return tmp;
-	}
+		:engine(engine_), name(name_), moduleStmts(arena.New<BlockStmt>(&arena)) {}
 
 	RespCode Module::CopyObjInto(ScriptObject *&dest, ScriptObject *src) {
 		// Checks if only one is class
@@ -178,106 +74,9 @@ namespace mlang {
 			dest = src;	// Simple memory copy
 			src->refCount++;
 		}
-		else if (!dest->GetType()->isClass) {
-			auto destType = dest->GetType();
-			auto srcType = src->GetType();
-			bool isDestFloat = destType->GetName() == "float" || destType->GetName() == "double";
-			bool isSrcFloat = srcType->GetName() == "float" || srcType->GetName() == "double";
-
-			if (isDestFloat && !isSrcFloat) {
-				uint64_t intSrc = 0;
-				switch (srcType->Size()) {
-					case 1:
-						intSrc = *reinterpret_cast<uint8_t *>(src->ptr);
-						break;
-					case 2:
-						intSrc = *reinterpret_cast<uint16_t *>(src->ptr);
-						break;
-					case 4:
-						intSrc = *reinterpret_cast<uint32_t *>(src->ptr);
-						break;
-					case 8:
-						intSrc = *reinterpret_cast<uint64_t *>(src->ptr);
-						break;
-				}
-
-				if (destType->GetName() == "float")
-					*static_cast<float *>(dest->ptr) = static_cast<float>(srcType->unsig ? intSrc : static_cast<int64_t>(intSrc));
-				else
-					*static_cast<double *>(dest->ptr) = static_cast<double>(srcType->unsig ? intSrc : static_cast<int64_t>(intSrc));
-			}
-			else if (!isDestFloat && isSrcFloat) {
-				void *srcPtr = src->ptr;
-				float *floatPtr = reinterpret_cast<float *>(srcPtr);
-				double *doublePtr = reinterpret_cast<double *>(srcPtr);
-
-				switch (destType->Size()) {
-					case 1:
-						*reinterpret_cast<uint8_t *>(dest->ptr) = static_cast<uint8_t>((srcType->GetName() == "float" ? *floatPtr : *doublePtr));
-						break;
-					case 2:
-						*reinterpret_cast<uint16_t *>(dest->ptr) = static_cast<uint16_t>((srcType->GetName() == "float" ? *floatPtr : *doublePtr));
-						break;
-					case 4:
-						*reinterpret_cast<uint32_t *>(dest->ptr) = static_cast<uint32_t>((srcType->GetName() == "float" ? *floatPtr : *doublePtr));
-						break;
-					case 8:
-						*reinterpret_cast<uint64_t *>(dest->ptr) = static_cast<uint64_t>((srcType->GetName() == "float" ? *floatPtr : *doublePtr));
-						break;
-				}
-			}
-			else if (isDestFloat == isSrcFloat) {
-				if (destType->Size() == srcType->Size()) {
-					std::memcpy(dest->ptr, src->ptr, destType->Size());
-					return RespCode::SUCCESS;
-				}
-
-				void *srcPtr = src->ptr;
-
-				if (isDestFloat) {
-					float *floatPtr = reinterpret_cast<float *>(srcPtr);
-					double *doublePtr = reinterpret_cast<double *>(srcPtr);
-				}
-				else {
-					uint64_t srcVal = 0;
-					// Sets the source value based on type
-					switch (srcType->Size()) {
-						case 1:
-							srcVal = static_cast<uint8_t>(*reinterpret_cast<uint8_t *>(srcPtr));
-							break;
-						case 2:
-							srcVal = static_cast<uint16_t>(*reinterpret_cast<uint16_t *>(srcPtr));
-							break;
-						case 4:
-							srcVal = static_cast<uint32_t>(*reinterpret_cast<uint32_t *>(srcPtr));
-							break;
-						case 8:
-							srcVal = static_cast<uint64_t>(*reinterpret_cast<uint64_t *>(srcPtr));
-							break;
-					}
-
-					// Sets destination value
-					switch (destType->Size()) {
-						case 1:
-							*reinterpret_cast<uint8_t *>(dest->ptr) = static_cast<uint8_t>(srcVal);
-							break;
-						case 2:
-							*reinterpret_cast<uint16_t *>(dest->ptr) = static_cast<uint16_t>(srcVal);
-							break;
-						case 4:
-							*reinterpret_cast<uint32_t *>(dest->ptr) = static_cast<uint32_t>(srcVal);
-							break;
-						case 8:
-							*reinterpret_cast<uint64_t *>(dest->ptr) = static_cast<uint64_t>(srcVal);
-							break;
-					}
-				}
-			}
-		}
 		else {
-			for (auto &[name, obj] : dest->members) {
-				CopyObjInto(obj, src->members.at(name));
-			}
+			// Primitives go through the conversion table, objects are copied flat
+			return ScriptObject::StoreFrom(dest->GetType(), dest->ptr, src->GetType(), src->ptr);
 		}
 		return RespCode::SUCCESS;
 	}
@@ -441,121 +240,27 @@ namespace mlang {
 		}
 	}
 
-	ScriptRval Module::EvaluateExpr(Scope *scope, Expression *expr) {
-		if (expr->type == Expression::Type::VALUE) {
-			auto casted = dynamic_cast<ValueExpr *>(expr);
-
-			if (casted->val.type >= Token::Type::LITERALS_BEGIN && casted->val.type <= Token::Type::LITERALS_END)
-				return ScriptRval::CreateFromLiteral(engine, casted->val.val);
-			if (casted->val.type != Token::Type::IDENTIFIER) {
-				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Invalid token " << casted->val.val << "\n";
-				errCode = RespCode::ERR;
-				return ScriptRval::CreateFromLiteral(engine, "0");
-			}
-
-			auto resolution = NameResolution(casted->val.val);
-			if (!resolution) {
-				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Invalid object " << casted->val.val << "\n";
-				errCode = RespCode::ERR;
-				return ScriptRval::CreateFromLiteral(engine, "0");
-			}
-			ScriptObject *objFound = std::get<ScriptObject *>(resolution.value());
-
-			if (objFound->GetType()->IsClass()) return ScriptRval::CreateFromLiteral(engine, "0");
-
-			auto objType = objFound->GetType();
-			void *ptr = objFound->GetAddressOfObj();
-
-			if (objType->GetName() != "float" && objType->GetName() != "double") {
-					switch (objType->Size()) {
-						case 1:
-							return (objType->IsUnsigned() ? 
-								ScriptRval::Create(engine, objType, *reinterpret_cast<uint8_t *>(ptr)) : 
-								ScriptRval::Create(engine, objType, *reinterpret_cast<int8_t *>(ptr)));
-						case 2:
-							return (objType->IsUnsigned() ?
-								ScriptRval::Create(engine, objType, *reinterpret_cast<uint16_t *>(ptr)) :
-								ScriptRval::Create(engine, objType, *reinterpret_cast<int16_t *>(ptr)));
-						case 4:
-							return (objType->IsUnsigned() ?
-								ScriptRval::Create(engine, objType, *reinterpret_cast<uint32_t *>(ptr)) :
-								ScriptRval::Create(engine, objType, *reinterpret_cast<int32_t *>(ptr)));
-						case 8:
-							return (objType->IsUnsigned() ?
-								ScriptRval::Create(engine, objType, *reinterpret_cast<uint64_t *>(ptr)) :
-								ScriptRval::Create(engine, objType, *reinterpret_cast<int64_t *>(ptr)));
-						default:
-							return ScriptRval::CreateFromLiteral(engine, "0");
-					}
-				}
-			else {
-				if (objType->GetName() == "float") {
-					return ScriptRval::Create(engine, objType, *reinterpret_cast<float *>(ptr));
-				}
-				else {
-					return ScriptRval::Create(engine, objType, *reinterpret_cast<double *>(ptr));
-				}
-			}
-
-			errCode = RespCode::ERR;
-			return ScriptRval::CreateFromLiteral(engine, "0");
+	RespCode Module::Build() {
+		if (Parse() != RespCode::SUCCESS) {
+			return RespCode::ERR;
 		}
-		else if (expr->type == Expression::Type::BINARY) {
-			auto casted = dynamic_cast<BinaryExpr *>(expr);
-			auto val = EvaluateExpr(scope, casted->lhs);
-
-			switch (casted->op.type) {
-				case Token::Type::PLUS:
-					return val + EvaluateExpr(scope, casted->rhs);
-				case Token::Type::MINUS:
-					return val - EvaluateExpr(scope, casted->rhs);
-				case Token::Type::STAR:
-					return val * EvaluateExpr(scope, casted->rhs);
-				case Token::Type::SLASH:
-					return val / EvaluateExpr(scope, casted->rhs);
-				case Token::Type::LESS:
-					return val < EvaluateExpr(scope, casted->rhs);
-				case Token::Type::LEQ:
-					return val <= EvaluateExpr(scope, casted->rhs);
-				case Token::Type::GREATER:
-					return val > EvaluateExpr(scope, casted->rhs);
-				case Token::Type::GEQ:
-					return val >= EvaluateExpr(scope, casted->rhs);
-				case Token::Type::NEQ:
-					return val != EvaluateExpr(scope, casted->rhs);
-			}
 
-			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Invalid operator" << casted->op.val << "\n";
-			errCode = RespCode::ERR;
-			return val;
-		}
-		else if (expr->type == Expression::Type::FUNCCALL) {
-			auto casted = dynamic_cast<FuncCallExpr *>(expr);
-
-			auto resolution = NameResolution(casted->funcName.val);
-			if (!resolution || !std::holds_alternative<ScriptFunc *>(resolution.value())) {
-				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Invalid function " << casted->funcName.val << "\n";
-				errCode = RespCode::ERR;
-				return ScriptRval::CreateFromLiteral(engine, "0");
-			}
-			ScriptFunc *funcFind = std::get<ScriptFunc*>(resolution.value());
-
-			if (!funcFind) return ScriptRval::CreateFromLiteral(engine, "0");
-			if (funcFind->returnType->GetName() == "void") return ScriptRval::CreateFromLiteral(engine, "0");
-
-			auto r = RunFunc(funcFind->GetUnderlyingFunc(), casted->params); assert(r == RespCode::SUCCESS);
+		return Link();
+	}
 
-			return *funcFind->func->funcScope->returnObj.get();
+	RespCode Module::Parse() {
+		if (!toks.empty() || context) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Module '" << name << "' was already built\n";
+			return RespCode::ERR;
 		}
 
-		errCode = RespCode::ERR;
-		return ScriptRval::CreateFromLiteral(engine, "0");
-	}
+		// Not a child of the global scope until it's linked, other modules may be parsing at the same time
+		moduleScope = std::make_unique<Scope>(engine, engine->GetScope());
+		currScope = moduleScope.get();
 
-	RespCode Module::Build() {
 		Token tok;
 
-		while ((tok = tokenizer.Tokenize()).type != Token::Type::END) {
+		while ((tok = tokenizer.Tokenize(engine->Symbols())).type != Token::Type::END) {
 			toks.push_back(tok);
 		}
 		toks.push_back(Token());	// Makes sure the last token is END token
@@ -577,270 +282,93 @@ namespace mlang {
 			moduleStmts->AddStatement(stmt);
 		}
 
-		// PrintStmt(moduleStmts.get());
+		// PrintStmt(moduleStmts);
 
 		return errCode;
 	}
 
-	RespCode Module::RunWhile(WhileStmt *stmt) {
-		while (EvaluateExpr(engine->GetScope(), stmt->cond)) {
-			auto scope = stmt->scope;
-			engine->SetScope(scope);
+	RespCode Module::Link() {
+		auto globalScope = engine->GetScope();
 
-			if (RunBlockStmt(dynamic_cast<BlockStmt*>(stmt->then)) != RespCode::SUCCESS) {
-				engine->SetScope(scope->parent);
-				return RespCode::ERR;
-			}
-
-			engine->SetScope(scope->parent);
-		}
-		return RespCode::SUCCESS;
-	}
-	RespCode Module::RunFunc(FuncStmt *stmt, std::vector<Expression *> params) {
-		auto scope = engine->GetScope();
-		if (stmt->funcScope->parentFunc->object) {
-			if (!stmt->funcScope->parentFunc->isConstMethod && stmt->funcScope->parentFunc->object->IsModifier(ScriptObject::Modifier::CONST)) {
-				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " "
-					<< "Calling non const function '" << stmt->ident.val << "' of const object '" << stmt->funcScope->parentFunc->object->GetName()
-					<< "' at line " << stmt->ident.row << "[" << stmt->ident.col << "]\n";
+		for (auto type : moduleScope->types) {
+			if (globalScope->FindTypeInfoByName(type->GetName()).code == RespCode::SUCCESS) {
+				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Type '" << type->GetName() << "' already exists\n";
 				return RespCode::ERR;
 			}
 		}
-		if (scope->parentFunc && stmt->funcScope->parentFunc) {
-			if (
-				scope->parentFunc->object != stmt->funcScope->parentFunc->object && 
-				stmt->funcScope->parentFunc->methodVisibility != TypeInfo::Visibility::PUBLIC) {
-				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " "
-					<< "Inacessible method '" << stmt->ident.val << "' at line " << stmt->ident.row << "[" << stmt->ident.col << "]\n";
-				return RespCode::ERR;
-			}
-		}
-
-		engine->SetScope(stmt->funcScope);
-		for (size_t i = 0; i < stmt->params.size(); ++i) {
-			auto funcParam = dynamic_cast<VarDeclStmt*>(stmt->params[i]);
-			auto providedValue = EvaluateExpr(stmt->funcScope, params[i]);
-
-			auto foundParam = stmt->funcScope->FindObjectByName(funcParam->ident.val).data;
-			if (!foundParam) continue;
-
-			foundParam.value()->SetVal(providedValue);
-			//ScriptObject tmpObj(engine, engine->GetScope()->FindTypeInfoByName("double").data.value());
-			//*reinterpret_cast<double *>(tmpObj.ptr) = providedValue;
-			//CopyObjInto(foundParam.value(), &tmpObj);
-		}
-
-		auto retCode = RunBlockStmt(dynamic_cast<BlockStmt *>(stmt->block));
-		engine->SetScope(scope);
-
-		return retCode;
-	}
-	RespCode Module::RunFuncCall(FuncCallStmt *stmt) {
-		auto scope = engine->GetScope();
-
-		auto nameResolved = NameResolution(stmt->funcName.val, scope);
-		if (!nameResolved || !std::holds_alternative<ScriptFunc *>(nameResolved.value())) {
-			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " 
-				<< "Invalid function '" << stmt->funcName.val << "' at line " << stmt->funcName.row << "[" << stmt->funcName.col << "]\n";
-			return RespCode::ERR;
-		}
-		ScriptFunc *foundFunc = std::get<ScriptFunc *>(nameResolved.value());
 
-		if (!scope->parentFunc->isMethod && scope->parentFunc->methodVisibility != TypeInfo::Visibility::PUBLIC) {
-			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " 
-				<< "Inacessible function '" << stmt->funcName.val << "' at line " << stmt->funcName.row << "[" << stmt->funcName.col << "]\n";;
-			return RespCode::ERR;
-		}
-		if (scope->parentFunc && scope->parentFunc->isConstMethod) {
-			if (!foundFunc->isConstMethod) {
-				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " 
-					<< "Call to non const function '" << stmt->funcName.val 
-					<< "' at line " << stmt->funcName.row << "[" << stmt->funcName.col << "]\n";
-				return RespCode::ERR;
-			}
-		}
-
-		//if (foundFunc->isMethod && scope->parentFunc->isMethod) {
-		//	foundFunc->object = scope->parentFunc->object;
-		//}
-
-		return RunFunc(foundFunc->func, stmt->params);
-	}
-	RespCode Module::RunReturn(ReturnStmt *stmt) {
-		auto scope = engine->GetScope();
-		if (!scope->IsOfType(Scope::Type::FUNCTION)) {
-			return RespCode::ERR;
-		}
-		if (stmt->val && scope->parentFunc->returnType->GetName() == "void") {
+		// Everything registered from here on is taken back if the module doesn't compile
+		auto typeCount = globalScope->types.size();
+		auto funcCount = globalScope->funcs.size();
+		auto objectCount = globalScope->objects.size();
+		auto typeIDCount = engine->TypeIDCount();
+
+		// The module's declarations become global, its scope stays as the parent of its children
+		for (auto type : moduleScope->types) {
+			globalScope->RegisterType(type);
+		}
+		for (auto func : moduleScope->funcs) {
+			globalScope->RegisterFunc(func);
+		}
+		for (auto obj : moduleScope->objects) {
+			globalScope->RegisterObject(obj);
+		}
+		for (auto type : classes) {
+			engine->RegisterTypeID(type);
+		}
+		moduleScope->types.clear();
+		moduleScope->funcs.clear();
+		moduleScope->objects.clear();
+		moduleScope->typeIndices.clear();
+		moduleScope->funcIndices.clear();
+		moduleScope->objectIndices.clear();
+		auto linkedScope = moduleScope.release();
+		globalScope->children.push_back(linkedScope);
+
+		Resolve();
+		if (Compile() != RespCode::SUCCESS) {
+			// Nothing was resolved against the module yet, its declarations go back to its scope
+			auto takeBack = [](auto &global, auto &local, auto &indices, size_t count) {
+				local.assign(global.begin() + count, global.end());
+				global.resize(count);
+				std::erase_if(indices, [count](const auto &idx) { return idx.second >= count; });
+			};
+			takeBack(globalScope->types, linkedScope->types, globalScope->typeIndices, typeCount);
+			takeBack(globalScope->funcs, linkedScope->funcs, globalScope->funcIndices, funcCount);
+			takeBack(globalScope->objects, linkedScope->objects, globalScope->objectIndices, objectCount);
+			engine->TruncateTypeIDs(typeIDCount);
+
+			std::erase(globalScope->children, linkedScope);
+			moduleScope.reset(linkedScope);
+			errCode = RespCode::ERR;
 			return RespCode::ERR;
 		}
 
-		if (!scope->returnObj) {
-			scope->returnObj = std::make_unique<ScriptRval>(EvaluateExpr(scope, stmt->val));
-		}
-		else {
-			*scope->returnObj.get() = EvaluateExpr(scope, stmt->val);
-		}
-
+		CreateOwnContext();
 		return RespCode::SUCCESS;
 	}
-	RespCode Module::RunIf(IfStmt *stmt) {
-		double value = EvaluateExpr(engine->GetScope(), stmt->condition);
-
-		if (value != 0) {
-			engine->SetScope(stmt->thenScope);
-			RunStmt(stmt->then);
-			engine->SetScope(stmt->thenScope->parent);
-		}
-		else if (stmt->els) {
-			engine->SetScope(stmt->elseScope);
-			RunStmt(stmt->els);
-			engine->SetScope(stmt->elseScope->parent);
+	void Module::CreateOwnContext() {
+		// The host reaches this module's objects in its own context
+		context = CreateContext();
+		for (auto obj : globals) {
+			obj->SetAddress(context->globals.get() + obj->frameOffset);
 		}
-
-		return RespCode::SUCCESS;
 	}
-	RespCode Module::RunBlockStmt(BlockStmt *stmt) {
-		for (auto &subStmt : stmt->stmts) {
-			if (RunStmt(subStmt) != RespCode::SUCCESS) {
-				return RespCode::ERR;
-			}
-			if (subStmt->type == Statement::Type::RETURN) {
-				return RespCode::SUCCESS;
-			}
-			if (subStmt->type == Statement::Type::BREAK) {
-				return RespCode::SUCCESS;
-			}
-		}
-
-		return RespCode::SUCCESS;
-	}
-	RespCode Module::RunVarDeclStmt(VarDeclStmt *stmt) {
-		auto scope = engine->GetScope();
 
-		if (scope->FindObjectByName(stmt->ident.val).code == RespCode::SUCCESS) {
-			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " "  << "Variable name '" << stmt->ident.val << "' already reserved at line " << stmt->ident.row << "[" << stmt->ident.col << "]\n";
-			return RespCode::ERR;
-		}
-
-		auto typeFind = scope->FindTypeInfoByName(stmt->type.val).data;
-		if (!typeFind) {
-			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " "  << "Type '" << stmt->type.val << "' not found at line " << stmt->ident.row << "[" << stmt->ident.col << "]\n";
-			return RespCode::ERR;
-		}
-
-		auto obj = new ScriptObject(engine, typeFind.value());
-		obj->modifiers = static_cast<ScriptObject::Modifier>(stmt->modifiers);
-		obj->identifier = stmt->ident.val;
-		scope->RegisterObject(obj);
-
-		auto foundObj = scope->FindObjectByName(stmt->ident.val).data;
-		if (!foundObj) {
-			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " "  << "Error instantiating '" << stmt->ident.val << "' at line " << stmt->ident.row << "[" << stmt->ident.col << "]\n";
-			return RespCode::ERR;
-		}
-
-		if (stmt->expr) {
-			if (dynamic_cast<ValueExpr *>(stmt->expr) && dynamic_cast<ValueExpr *>(stmt->expr)->val.type == Token::Type::IDENTIFIER) {
-				auto nameResolution = NameResolution(dynamic_cast<ValueExpr *>(stmt->expr)->val.val);
-
-				ScriptObject *foundSrc = std::get<ScriptObject*>(nameResolution.value());
-
-				std::cout << stmt->ident.val << " initialized to " << dynamic_cast<ValueExpr *>(stmt->expr)->val.val << "\n";
-				return CopyObjInto(foundObj.value(), foundSrc);
-			}
-
-			auto expr = EvaluateExpr(scope, stmt->expr);
-			
-			return foundObj.value()->SetVal(expr);
-		}
-
-		return RespCode::SUCCESS;
-	}
-	RespCode Module::RunVarAssignStmt(VarAssignStmt *stmt) {
-		auto scope = engine->GetScope();
-
-		std::optional<std::variant<ScriptFunc *, ScriptObject *>> nameResolution = std::nullopt;
-
-		nameResolution = NameResolution(stmt->ident.val);
-		if (!nameResolution || !std::holds_alternative<ScriptObject *>(nameResolution.value())) {
-			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Invalid variable '" << stmt->ident.val << "' at line " << stmt->ident.row << "[" << stmt->ident.col << "]\n";
-			return RespCode::ERR;
-		}
-
-		ScriptObject *foundObj = std::get<ScriptObject *>(nameResolution.value());
-		if (foundObj->IsModifier(ScriptObject::Modifier::CONST)) {
-			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " <<
-				"Assigning a value to a const object '" << foundObj->GetName() << "' at line " << stmt->ident.row << "[" << stmt->ident.col << "]\n";
-			return RespCode::ERR;
-		}
-		if (scope->parentFunc->isConstMethod) {
-			if (foundObj->parentClass == scope->parentFunc->object) {
-				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " <<
-					"Assigning a member in constant method '" << scope->parentFunc->GetName() << "' at line " << stmt->ident.row << "[" << stmt->ident.col << "]\n";
-				return RespCode::ERR;
-			}
-		}
-
-		if ((!scope->parentFunc || !scope->parentFunc->isMethod) && foundObj->GetType()->visibility != TypeInfo::Visibility::PUBLIC) {
-			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " <<
-				"Inacessible member '" << foundObj->GetName() << "' at line " << stmt->ident.row << "[" << stmt->ident.col << "]\n";
-			return RespCode::ERR;
-		}
-
-		auto expr = EvaluateExpr(scope, stmt->expr);
-
-		auto retCode = foundObj->SetVal(expr);
-
-		if (retCode == RespCode::SUCCESS) {
-			std::cout << stmt->ident.val << " set to " << *reinterpret_cast<int*>(foundObj->GetAddressOfObj()) << "\n";
-		}
-
-		return retCode;
-	}
-	RespCode Module::RunStmt(Statement *stmt) {
-		switch (stmt->type) {
-			case Statement::Type::BLOCK:
-				return RunBlockStmt(dynamic_cast<BlockStmt *>(stmt));
-			case Statement::Type::VARDECL:
-				return RunVarDeclStmt(dynamic_cast<VarDeclStmt *>(stmt));
-			case Statement::Type::ASSIGNEMENT:
-				return RunVarAssignStmt(dynamic_cast<VarAssignStmt *>(stmt));
-			case Statement::Type::IF:
-				return RunIf(dynamic_cast<IfStmt *>(stmt));
-			case Statement::Type::WHILE:
-				return RunWhile(dynamic_cast<WhileStmt *>(stmt));
-			case Statement::Type::FUNCCALL:
-				return RunFuncCall(dynamic_cast<FuncCallStmt *>(stmt));
-			case Statement::Type::RETURN:
-				return RunReturn(dynamic_cast<ReturnStmt *>(stmt));
-			default:
-				return RespCode::ERR;
-		}
-	}
 	RespCode Module::Run() {
-		if (!moduleStmts) {
+		if (!context) {
 			return RespCode::ERR;
 		}
 
-		for (Statement *stmt : moduleStmts->stmts) {
-			if (stmt->type != Statement::Type::FUNCDEF) {
-				if (RunStmt(stmt) == RespCode::ERR) {
-					return RespCode::ERR;
-				}
-				continue;
-			}
-
-			FuncStmt *castedStmt = dynamic_cast<FuncStmt *>(stmt);
-			if (castedStmt->ident.val != "main") continue;
-
-			auto toRet = RunFunc(castedStmt, std::vector<Expression*>());
-
-			castedStmt->funcScope->returnObj.release();
+		return context->Run();
+	}
 
-			return RespCode::SUCCESS;
+	ScriptFunc *Module::FindFunction(std::string_view name) const {
+		// Loaded modules have no statements to compare symbols with
+		for (auto func : functions) {
+			if (!func->isMethod && func->GetName() == name) return func;
 		}
 
-		return RespCode::ERR;
+		return nullptr;
 	}
 }
\ No newline at end of file
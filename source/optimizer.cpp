@@ -0,0 +1,431 @@
+#include <marklang.h>
+#include <cstring>
+
+namespace mlang {
+	// Kinds on the bytecode's stack before an instruction, the slot of a value is its depth
+	using StackKinds = std::vector<NumericKind>;
+
+	static bool IsPrimitive(const TypeInfo *type) {
+		return type && type->Kind() != NumericKind::NONE;
+	}
+	// Bigger functions are always called
+	static constexpr size_t maxInlineSize = 32;
+
+	void Module::Inline(ScriptFunc *caller) {
+		auto &source = *caller->code;
+
+		// Leaf functions of the module without loops that return a primitive or nothing. Typed functions are
+		// left to run typed when the caller runs in bytecode, functions with native code keep running it
+		auto inlinable = [this, caller](const ScriptFunc *callee) {
+			auto code = callee->code.get();
+			if (callee == caller || !code || callee->module != this || code->code.size() > maxInlineSize) return false;
+			if (callee->IsOptimized() && !caller->IsOptimized()) return false;
+			if (callee->native || callee->aot || (callee->optimized && callee->optimized->jit.load(std::memory_order_relaxed))) return false;
+
+			auto returnType = callee->returnType;
+			if (!IsPrimitive(returnType) && returnType->Size()) return false;
+
+			for (uint32_t i = 0; i < code->code.size(); ++i) {
+				auto &inst = code->code[i];
+				if (inst.op == OpCode::CALL || inst.op == OpCode::HALT) return false;
+				// Typed code can't enter a loop with values on the stack
+				if ((inst.op == OpCode::JUMP || inst.op == OpCode::JUMP_IF_FALSE) && inst.arg <= i) return false;
+			}
+			return true;
+		};
+
+		Bytecode ret;
+		ret.constants = source.constants;
+		ret.bindings = source.bindings;
+		ret.errors = source.errors;
+
+		// Inlined locals live past the caller's, every call site reuses them. The frame only grows if the new code is kept
+		auto region = caller->frameSize;
+		auto frameSize = caller->frameSize;
+		std::vector<uint32_t> newIndex(source.code.size() + 1);
+		std::vector<uint32_t> callerJumps;
+		bool inlined = false;
+
+		auto emit = [&ret](OpCode op, uint32_t arg = 0, uint32_t arg2 = 0) {
+			ret.code.push_back(Instruction{ op, arg, arg2 });
+			return static_cast<uint32_t>(ret.code.size() - 1);
+		};
+		auto bind = [&ret](const Binding &binding) {
+			ret.bindings.push_back(binding);
+			return static_cast<uint32_t>(ret.bindings.size() - 1);
+		};
+		auto local = [&](const TypeInfo *type, size_t offset) {
+			Binding binding;
+			binding.kind = Binding::Kind::OBJECT;
+			binding.base = Binding::Base::FRAME;
+			binding.offset = offset;
+			binding.type = type;
+			return bind(binding);
+		};
+
+		for (uint32_t i = 0; i < source.code.size(); ++i) {
+			auto &inst = source.code[i];
+			newIndex[i] = static_cast<uint32_t>(ret.code.size());
+
+			const Binding *call = (inst.op == OpCode::CALL ? &source.bindings[inst.arg] : nullptr);
+			auto callee = (call ? call->func : nullptr);
+			if (!callee || inst.arg2 != callee->paramCount || callee->params.size() != inst.arg2 || !inlinable(callee)) {
+				if (inst.op == OpCode::JUMP || inst.op == OpCode::JUMP_IF_FALSE) callerJumps.push_back(static_cast<uint32_t>(ret.code.size()));
+				ret.code.push_back(inst);
+				continue;
+			}
+
+			auto &body = *callee->code;
+			auto returnType = callee->returnType;
+			auto retOffset = region + callee->frameSize;
+			frameSize = std::max(frameSize, retOffset + sizeof(uint64_t));
+			inlined = true;
+
+			// The callee's bindings, its object's members are reached through the call's binding
+			auto remap = [&](Binding binding) {
+				if (binding.base == Binding::Base::FRAME) {
+					binding.offset += region;
+				}
+				else if (binding.base == Binding::Base::THIS) {
+					binding.base = call->base;
+					binding.module = call->module;
+					binding.offset += call->offset;
+				}
+				return binding;
+			};
+
+			// Parameters were pushed in order, the last one is on top
+			auto &params = callee->params;
+			for (size_t p = params.size(); p-- > 0;) {
+				Binding binding;
+				binding.kind = Binding::Kind::OBJECT;
+				binding.type = params[p].type;
+				binding.base = Binding::Base::FRAME;
+				binding.offset = params[p].offset + region;
+				emit(OpCode::DECLARE, bind(binding), 1);
+			}
+
+			// Returns store the converted value and jump past the body
+			std::vector<uint32_t> bodyIndex(body.code.size());
+			std::vector<std::pair<uint32_t, uint32_t>> bodyJumps;
+			std::vector<uint32_t> exits;
+			for (uint32_t b = 0; b < body.code.size(); ++b) {
+				auto &bodyInst = body.code[b];
+				bodyIndex[b] = static_cast<uint32_t>(ret.code.size());
+
+				switch (bodyInst.op) {
+					case OpCode::PUSH_CONST:
+						ret.constants.push_back(body.constants[bodyInst.arg]);
+						emit(OpCode::PUSH_CONST, static_cast<uint32_t>(ret.constants.size() - 1));
+						break;
+					case OpCode::LOAD:
+					case OpCode::STORE:
+					case OpCode::DECLARE:
+						emit(bodyInst.op, bind(remap(body.bindings[bodyInst.arg])), bodyInst.arg2);
+						break;
+					case OpCode::FAIL:
+						ret.errors.push_back(body.errors[bodyInst.arg]);
+						emit(OpCode::FAIL, static_cast<uint32_t>(ret.errors.size() - 1));
+						break;
+					case OpCode::JUMP:
+					case OpCode::JUMP_IF_FALSE:
+						bodyJumps.emplace_back(emit(bodyInst.op), bodyInst.arg);
+						break;
+					case OpCode::RETURN:
+						emit(OpCode::DECLARE, local(returnType, retOffset), 1);
+						exits.push_back(emit(OpCode::JUMP));
+						break;
+					case OpCode::RETURN_VOID:
+						// Functions falling off their end return 0
+						if (returnType->Size()) {
+							ret.constants.push_back(ScriptRval::Create<int32_t>(engine, engine->GetPrimitive(Engine::Primitive::INT32), 0));
+							emit(OpCode::PUSH_CONST, static_cast<uint32_t>(ret.constants.size() - 1));
+							emit(OpCode::DECLARE, local(returnType, retOffset), 1);
+						}
+						exits.push_back(emit(OpCode::JUMP));
+						break;
+					default:
+						emit(bodyInst.op, bodyInst.arg, bodyInst.arg2);
+						break;
+				}
+			}
+
+			for (auto [jump, target] : bodyJumps) {
+				ret.code[jump].arg = (target < body.code.size() ? bodyIndex[target] : static_cast<uint32_t>(ret.code.size()));
+			}
+			for (auto exit : exits) {
+				ret.code[exit].arg = static_cast<uint32_t>(ret.code.size());
+			}
+
+			// Void functions leave an int 0 behind like calls do
+			if (returnType->Size()) {
+				emit(OpCode::LOAD, local(returnType, retOffset));
+			}
+			else {
+				ret.constants.push_back(ScriptRval::Create<int32_t>(engine, engine->GetPrimitive(Engine::Primitive::INT32), 0));
+				emit(OpCode::PUSH_CONST, static_cast<uint32_t>(ret.constants.size() - 1));
+			}
+		}
+		newIndex[source.code.size()] = static_cast<uint32_t>(ret.code.size());
+
+		if (!inlined) return;
+
+		for (auto jump : callerJumps) {
+			ret.code[jump].arg = newIndex[ret.code[jump].arg];
+		}
+
+		// Typed callers keep the calls if the inlined code can't be translated
+		bool wasOptimized = caller->IsOptimized();
+		std::swap(*caller->code, ret);
+		caller->Optimize();
+		if (wasOptimized && !caller->IsOptimized()) {
+			std::swap(*caller->code, ret);
+			caller->Optimize();
+			return;
+		}
+
+		caller->frameSize = frameSize;
+	}
+
+	void ScriptFunc::Optimize() {
+		auto &source = *code;
+		optimized.reset();
+
+		auto ret = std::make_unique<OptimizedCode>();
+		ret->source = &source;
+		ret->returnType = returnType;
+		ret->code.resize(source.code.size());
+
+		// Every instruction is reached with the same kinds on the stack from everywhere
+		std::vector<std::optional<StackKinds>> before(source.code.size());
+		std::vector<uint32_t> pending = { 0 };
+		before[0] = StackKinds{};
+
+		bool supported = true;
+		auto reach = [&](uint32_t idx, const StackKinds &kinds) {
+			if (idx >= source.code.size()) {
+				supported = false;
+				return;
+			}
+			if (!before[idx]) {
+				before[idx] = kinds;
+				pending.push_back(idx);
+			}
+			else if (*before[idx] != kinds) {
+				supported = false;
+			}
+		};
+
+		while (!pending.empty() && supported) {
+			auto idx = pending.back();
+			pending.pop_back();
+
+			auto &inst = source.code[idx];
+			auto &typed = ret->code[idx];
+			auto kinds = *before[idx];
+			auto top = static_cast<uint32_t>(kinds.size());
+			bool fallsThrough = true;
+
+			ret->slotCount = std::max<size_t>(ret->slotCount, kinds.size() + 1);
+
+			switch (inst.op) {
+				case OpCode::PUSH_CONST: {
+					auto &constant = source.constants[inst.arg];
+					if (!IsPrimitive(constant.valueType)) {
+						supported = false;
+						break;
+					}
+
+					uint64_t bits = 0;
+					std::memcpy(&bits, constant.data, constant.valueType->Size());
+					ret->constants.push_back(bits);
+
+					typed = TypedInstruction{ TypedOp::CONST, constant.valueType->Kind(), 0, top, static_cast<uint32_t>(ret->constants.size() - 1) };
+					kinds.push_back(constant.valueType->Kind());
+					break;
+				}
+				case OpCode::LOAD: {
+					auto &binding = source.bindings[inst.arg];
+					if (!IsPrimitive(binding.type)) {
+						supported = false;
+						break;
+					}
+
+					if (binding.base == Binding::Base::FRAME) {
+						typed = TypedInstruction{ TypedOp::LOAD_FRAME, binding.type->Kind(), static_cast<uint8_t>(binding.type->Size()), top, static_cast<uint32_t>(binding.offset) };
+					}
+					else {
+						typed = TypedInstruction{ TypedOp::LOAD, binding.type->Kind(), static_cast<uint8_t>(binding.type->Size()), top, inst.arg };
+					}
+					kinds.push_back(binding.type->Kind());
+					break;
+				}
+				case OpCode::STORE:
+				case OpCode::DECLARE: {
+					auto &binding = source.bindings[inst.arg];
+					if (!IsPrimitive(binding.type)) {
+						supported = false;
+						break;
+					}
+
+					if (inst.op == OpCode::DECLARE && !inst.arg2) {
+						typed = TypedInstruction{ TypedOp::ZERO, binding.type->Kind(), static_cast<uint8_t>(binding.type->Size()), 0, inst.arg };
+						break;
+					}
+					if (kinds.empty()) {
+						supported = false;
+						break;
+					}
+
+					typed = TypedInstruction{ TypedOp::STORE, binding.type->Kind(), static_cast<uint8_t>(binding.type->Size()), top - 1, inst.arg };
+					typed.from = kinds.back();
+					typed.convert = GetConversion(typed.from, binding.type->Kind());
+					kinds.pop_back();
+					if (binding.base == Binding::Base::FRAME) {
+						typed.op = TypedOp::STORE_FRAME;
+						typed.arg = static_cast<uint32_t>(binding.offset);
+					}
+					supported = (typed.convert != nullptr);
+					break;
+				}
+				case OpCode::POP:
+					if (kinds.empty()) {
+						supported = false;
+						break;
+					}
+
+					kinds.pop_back();
+					typed = TypedInstruction{ TypedOp::NOP };
+					break;
+				case OpCode::FAIL:
+					typed = TypedInstruction{ TypedOp::FAIL, NumericKind::NONE, 0, 0, inst.arg };
+					fallsThrough = false;
+					break;
+
+				case OpCode::ADD:
+				case OpCode::SUB:
+				case OpCode::MUL:
+				case OpCode::DIV:
+				case OpCode::LESS:
+				case OpCode::LEQ:
+				case OpCode::GREATER:
+				case OpCode::GEQ:
+				case OpCode::EQ:
+				case OpCode::NEQ: {
+					if (kinds.size() < 2) {
+						supported = false;
+						break;
+					}
+
+					NumericKind result;
+					typed = TypedInstruction{ TypedOp::COMPUTE, NumericKind::NONE, 0, top - 2, top - 1 };
+					typed.kernel = GetKernel(inst.op, kinds[top - 2], kinds[top - 1], result);
+					if (!typed.kernel) {
+						supported = false;
+						break;
+					}
+
+					typed.kind = result;
+					typed.from = kinds[top - 2];
+					typed.fromArg = kinds[top - 1];
+					kinds.pop_back();
+					kinds.back() = result;
+					break;
+				}
+
+				case OpCode::JUMP:
+					typed = TypedInstruction{ (inst.arg <= idx ? TypedOp::LOOP : TypedOp::JUMP), NumericKind::NONE, 0, 0, inst.arg };
+					// The machine code takes over at the head of loops, nothing may be on the stack there
+					if (typed.op == TypedOp::LOOP && !kinds.empty()) supported = false;
+
+					reach(inst.arg, kinds);
+					fallsThrough = false;
+					break;
+				case OpCode::JUMP_IF_FALSE:
+					if (kinds.empty()) {
+						supported = false;
+						break;
+					}
+
+					typed = TypedInstruction{ TypedOp::JUMP_IF_FALSE, kinds.back(), 0, top - 1, inst.arg };
+					typed.from = kinds.back();
+					typed.convert = GetConversion(kinds.back(), NumericKind::BOOL);
+					kinds.pop_back();
+
+					reach(inst.arg, kinds);
+					break;
+				case OpCode::CALL: {
+					auto &binding = source.bindings[inst.arg];
+					auto callee = binding.func;
+					if (!callee || inst.arg2 != callee->paramCount || callee->params.size() != callee->paramCount || kinds.size() < inst.arg2) {
+						supported = false;
+						break;
+					}
+
+					// Void functions leave an int 0 behind
+					auto result = (callee->returnType->Size() ? callee->returnType->Kind() : NumericKind::INT32);
+					if (result == NumericKind::NONE) {
+						supported = false;
+						break;
+					}
+
+					auto first = top - inst.arg2;
+					auto size = static_cast<uint8_t>(callee->returnType->Size() ? callee->returnType->Size() : sizeof(int32_t));
+					typed = TypedInstruction{ TypedOp::CALL, result, size, first, inst.arg, inst.arg2, static_cast<uint32_t>(ret->conversions.size()) };
+					for (uint32_t i = 0; i < inst.arg2; ++i) {
+						auto convert = GetConversion(kinds[first + i], callee->params[i].type->Kind());
+						if (!convert) supported = false;
+
+						ret->conversions.push_back(convert);
+						ret->argKinds.push_back(kinds[first + i]);
+					}
+
+					kinds.resize(first);
+					kinds.push_back(result);
+					break;
+				}
+				case OpCode::RETURN:
+					if (kinds.empty() || !IsPrimitive(returnType)) {
+						supported = false;
+						break;
+					}
+
+					typed = TypedInstruction{ TypedOp::RETURN, returnType->Kind(), 0, top - 1 };
+					typed.from = kinds.back();
+					typed.convert = GetConversion(typed.from, returnType->Kind());
+					supported = (typed.convert != nullptr);
+					fallsThrough = false;
+					break;
+				case OpCode::RETURN_VOID:
+					typed = TypedInstruction{ TypedOp::RETURN_VOID };
+					fallsThrough = false;
+					break;
+				default:
+					supported = false;
+					break;
+			}
+
+			if (supported && fallsThrough) reach(idx + 1, kinds);
+		}
+
+		if (!supported) return;
+
+		// Instructions never reached are left as NOPs
+		ret->func = this;
+		for (auto &typed : ret->code) {
+			if (typed.op == TypedOp::JUMP || typed.op == TypedOp::LOOP || typed.op == TypedOp::JUMP_IF_FALSE) typed.target = &ret->code[typed.arg];
+			typed.handler = ExecutionContext::HandlerFor(typed);
+		}
+		optimized = std::move(ret);
+	}
+	void ScriptFunc::CompileNative() {
+		auto jit = JitCode::Compile(*optimized);
+		if (!jit) return;
+
+		// Contexts on other threads may be running the function
+		JitCode *expected = nullptr;
+		if (optimized->jit.compare_exchange_strong(expected, jit.get(), std::memory_order_release)) {
+			jit.release();
+		}
+	}
+}
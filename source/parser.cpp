@@ -1,6 +1,7 @@
 #include <marklang.h>
 #include <iostream>
 #include <unordered_set>
+#include <charconv>
 
 #ifndef __FUNCTION_NAME__
 #if defined(WIN32) || defined(_WIN32)
@@ -15,11 +16,8 @@
 #endif
 
 namespace mlang {
-	static bool inMethod = false;
-	static bool constMethod = false;
-
 	// Tokenizer
-	static const std::unordered_map<std::string, Token::Type> keywords = {
+	static const std::unordered_map<std::string_view, Token::Type> keywords = {
 		{"void", Token::Type::VOID},
 
 		{"bool", Token::Type::BOOL},
@@ -56,49 +54,61 @@ namespace mlang {
 		{ Token::Type::ASSIGN_DIV, Token::Type::SLASH },
 	}};
 
-	Token Module::Tokenizer::Tokenize() {
-		if (currIdx >= code.size()) return Token(Token::Type::END, "", currRow, currCol);
+	Token Module::Tokenizer::Make(Token::Type type, size_t length) {
+		Token ret(type, code.substr(currIdx, length), currRow, currCol);
+
+		currIdx += length;
+		currCol += static_cast<int>(length);
+		return ret;
+	}
+	Token Module::Tokenizer::Tokenize(SymbolTable &symbols) {
+		while (true) {
+			// Skip whitespace
+			while (currIdx < code.size() && std::isspace(code[currIdx])) {
+				if (code[currIdx] == '\n') {
+					currRow++;
+					currCol = 1;
+				}
+				else if (code[currIdx] == '\r') { currCol = 0; }
+				else { currCol++; }
 
-		// Skip whitespace
-		while (currIdx < code.size() && std::isspace(code[currIdx])) {
-			if (code[currIdx] == '\n') {
-				currRow++;
-				currCol = 1;
+				currIdx++;
 			}
-			else if (code[currIdx] == '\r') { currCol = 0; }
-			else { currCol++; }
+			if (currIdx < code.size()) break;
 
-			currIdx++;
+			// Tokens don't span sections, rows keep counting
+			if (nextSection >= sections.size()) return Token(Token::Type::END, "", currRow, currCol);
+			code = sections[nextSection++];
+			currIdx = 0;
 		}
-		if (currIdx >= code.size()) return Token(Token::Type::END, "", currRow, currCol);
-
 
 		// Check if identifier or keyword
 		if (std::isalpha(code[currIdx]) || code[currIdx] == '_') {
-			std::string tmp;
-			while (currIdx < code.size() && (std::isalnum(code[currIdx]) || code[currIdx] == '_')) {
-				tmp += code[currIdx++];
-				currCol++;
+			size_t length = 0;
+			while (currIdx + length < code.size() && (std::isalnum(code[currIdx + length]) || code[currIdx + length] == '_')) {
+				length++;
 			}
 
-			if (keywords.contains(tmp)) {
-				return Token(keywords.at(tmp), tmp, currRow, currCol);
+			auto ret = Make(Token::Type::IDENTIFIER, length);
+			if (auto keyword = keywords.find(ret.val); keyword != keywords.end()) {
+				ret.type = keyword->second;
+				return ret;
 			}
 
-			return Token(Token::Type::IDENTIFIER, tmp, currRow, currCol - (int)tmp.size());
+			ret.sym = symbols.Intern(ret.val);
+			return ret;
 		}
 
 		// Check if numeric
 		if (std::isdigit(code[currIdx])) {
-			std::string tmp;
+			size_t length = 0;
 			bool digitFound = false;
-			while (currIdx < code.size() && (std::isdigit(code[currIdx]) || (code[currIdx] == '.' && !digitFound))) {
-				if (code[currIdx] == '.') digitFound = true;
-				tmp += code[currIdx++];
-				currCol++;
+			while (currIdx + length < code.size() && (std::isdigit(code[currIdx + length]) || (code[currIdx + length] == '.' && !digitFound))) {
+				if (code[currIdx + length] == '.') digitFound = true;
+				length++;
 			}
 
-			return Token((digitFound ? Token::Type::DECIMAL : Token::Type::INTEGER), tmp, currRow, currCol - (int)tmp.size());
+			return Make((digitFound ? Token::Type::DECIMAL : Token::Type::INTEGER), length);
 		}
 
 		// Special characters (. * + >=) and more
@@ -106,91 +116,117 @@ namespace mlang {
 		switch (code[currIdx]) {
 			case '+': {
 				if (lookahead == '=') {
-					return Token(Token::Type::ASSIGN_PLUS, std::string{ code[currIdx++], code[currIdx++] }, currRow, currCol++);
+					return Make(Token::Type::ASSIGN_PLUS, 2);
 				}
-				return Token(Token::Type::PLUS, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::PLUS, 1);
 			}
 			case '-': {
 				if (lookahead == '=') {
-					return Token(Token::Type::ASSIGN_MINUS, std::string{ code[currIdx++], code[currIdx++] }, currRow, currCol++);
+					return Make(Token::Type::ASSIGN_MINUS, 2);
 				}
-				return Token(Token::Type::MINUS, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::MINUS, 1);
 			}
 			case '*': {
 				if (lookahead == '=') {
-					return Token(Token::Type::ASSIGN_MUL, std::string{ code[currIdx++], code[currIdx++] }, currRow, currCol++);
+					return Make(Token::Type::ASSIGN_MUL, 2);
 				}
-				return Token(Token::Type::STAR, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::STAR, 1);
 			}
 			case '/': {
 				if (lookahead == '=') {
-					return Token(Token::Type::ASSIGN_DIV, std::string{ code[currIdx++], code[currIdx++] }, currRow, currCol++);
+					return Make(Token::Type::ASSIGN_DIV, 2);
 				}
-				return Token(Token::Type::SLASH, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::SLASH, 1);
 			}
 
 			case '(': {
-				return Token(Token::Type::OPEN_PARENTH, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::OPEN_PARENTH, 1);
 			}
 			case ')': {
-				return Token(Token::Type::CLOSED_PARENTH, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::CLOSED_PARENTH, 1);
 			}
 			case '{': {
-				return Token(Token::Type::OPEN_BRACE, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::OPEN_BRACE, 1);
 			}
 			case '}': {
-				return Token(Token::Type::CLOSED_BRACE, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::CLOSED_BRACE, 1);
 			}
 			case '[': {
-				return Token(Token::Type::OPEN_BRACKET, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::OPEN_BRACKET, 1);
 			}
 			case ']': {
-				return Token(Token::Type::CLOSED_BRACKET, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::CLOSED_BRACKET, 1);
 			}
 
 			case ';': {
-				return Token(Token::Type::SEMICOLON, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::SEMICOLON, 1);
 			}
 			case ',': {
-				return Token(Token::Type::COMMA, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::COMMA, 1);
 			}
 			case '.': {
-				return Token(Token::Type::DOT, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::DOT, 1);
 			}
 			case ':': {
-				return  Token(Token::Type::DOUBLECOLON, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::DOUBLECOLON, 1);
 			}
 			case '=': {
 				if (lookahead == '=') {
-					return Token(Token::Type::EQ, std::string{ code[currIdx++], code[currIdx++] }, currRow, currCol++);
+					return Make(Token::Type::EQ, 2);
 				}
-				return  Token(Token::Type::ASSIGN, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::ASSIGN, 1);
 			}
 
 			case '!': {
 				if (lookahead == '=') {
-					return Token(Token::Type::NEQ, std::string{ code[currIdx++], code[currIdx++] }, currRow, currCol++);
+					return Make(Token::Type::NEQ, 2);
 				}
-				return  Token(Token::Type::NOT, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::NOT, 1);
 			}
 			case '<': {
 				if (lookahead == '=') {
-					return Token(Token::Type::LEQ, std::string{ code[currIdx++], code[currIdx++] }, currRow, currCol++);
+					return Make(Token::Type::LEQ, 2);
 				}
-				return Token(Token::Type::LESS, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::LESS, 1);
 			}
 			case '>': {
 				if (lookahead == '=') {
-
-					return  Token(Token::Type::GEQ, std::string{ code[currIdx++], code[currIdx++] }, currRow, currCol++);
+					return Make(Token::Type::GEQ, 2);
 				}
-				return  Token(Token::Type::GREATER, std::string{ code[currIdx++] }, currRow, currCol++);
+				return Make(Token::Type::GREATER, 1);
 			}
 		}
 
 		return Token();
 	}
 
+	std::optional<Literal> Literal::Parse(std::string_view text) {
+		Literal ret;
+		auto begin = text.data(), end = text.data() + text.size();
+
+		if (text.find('.') != std::string_view::npos) {
+			ret.type = Engine::Primitive::FLOAT;
+			auto result = std::from_chars(begin, end, ret.f32);
+			if (result.ec == std::errc::result_out_of_range) {
+				ret.type = Engine::Primitive::DOUBLE;
+				result = std::from_chars(begin, end, ret.f64);
+			}
+
+			if (result.ec != std::errc() || result.ptr != end) return std::nullopt;
+			return ret;
+		}
+
+		ret.type = Engine::Primitive::INT32;
+		auto result = std::from_chars(begin, end, ret.i32);
+		if (result.ec == std::errc::result_out_of_range) {
+			ret.type = Engine::Primitive::INT64;
+			result = std::from_chars(begin, end, ret.i64);
+		}
+
+		if (result.ec != std::errc() || result.ptr != end) return std::nullopt;
+		return ret;
+	}
+
 	static int Precedence(Token::Type tok) {
 		using Type = Token::Type;
 
@@ -205,6 +241,7 @@ namespace mlang {
 			case Type::LEQ:
 			case Type::GREATER:
 			case Type::GEQ:
+			case Type::EQ:
 			case Type::NEQ:
 				return 1;
 			default:
@@ -220,6 +257,18 @@ namespace mlang {
 
 		return &toks[idx];
 	}
+	void Module::JoinToken(Token &tok, const Token &next) {
+		auto &symbols = engine->Symbols();
+
+		// Adjacent in the source, the view only grows
+		if (tok.val.data() + tok.val.size() == next.val.data()) {
+			tok.val = std::string_view(tok.val.data(), tok.val.size() + next.val.size());
+		}
+		else {
+			tok.val = symbols.Name(symbols.Intern(std::string(tok.val) + std::string(next.val)));
+		}
+		tok.sym = symbols.Intern(tok.val);
+	}
 	Expression *Module::ParseExpression(int precedence) {
 		auto left = ParsePrimaryExpr();
 
@@ -229,13 +278,22 @@ namespace mlang {
 
 			auto op = NextToken();
 			auto right = ParseExpression(thisPrecedence);
-			left = new BinaryExpr(left, *op, right);
+			left = arena.New<BinaryExpr>(left, *op, right);
 		}
 		return left;
 	}
 	Expression *Module::ParsePrimaryExpr() {
 		if (currTok->type == Token::Type::INTEGER || currTok->type == Token::Type::DECIMAL) {
-			return new ValueExpr(*NextToken());
+			auto tok = NextToken();
+
+			auto literal = Literal::Parse(tok->val);
+			if (!literal) {
+				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Invalid literal '" << tok->val << "' at line " << tok->row << "[" << tok->col << "]\n";
+				errCode = RespCode::ERR;
+				return nullptr;
+			}
+
+			return arena.New<ValueExpr>(*tok, literal.value());
 		}
 		else if (currTok->type == Token::Type::IDENTIFIER) {
 			auto nameTok = *NextToken();
@@ -243,19 +301,17 @@ namespace mlang {
 
 			if (GetToken()->type == Token::Type::OPEN_PARENTH) {
 				NextToken();
-				std::vector<Expression *> params;
+				ArenaVector<Expression *> params(&arena);
 
 				if (GetToken()->type == Token::Type::CLOSED_PARENTH) {
 					NextToken();
-					return new FuncCallExpr(nameTok, std::vector<Expression *>());
+					return arena.New<FuncCallExpr>(nameTok, ArenaVector<Expression *>(&arena));
 				}
 				while (true) {
 					auto expr = ParseExpression();
 					if (!expr) {
 						std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Invalid parameter n" << params.size() + 1 << "' at line " << GetToken()->row << "[" << GetToken()->col << "]\n";
 						errCode = RespCode::ERR;
-						for (auto param : params) delete param;
-
 						return nullptr;
 					}
 
@@ -267,37 +323,33 @@ namespace mlang {
 					if (GetToken()->type != Token::Type::CLOSED_PARENTH) {
 						std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Invalid value '" << GetToken()->val << "' at line " << GetToken()->row << "[" << GetToken()->col << "]\n";
 						errCode = RespCode::ERR;
-						for (auto param : params) delete param;
-
 						return nullptr;
 					}
 
 					NextToken();
 					break;
 				}
-				return new FuncCallExpr(nameTok, params);
+				return arena.New<FuncCallExpr>(nameTok, std::move(params));
 			}
 			else if (GetToken()->type == Token::Type::DOT) {
 				while (GetToken()->type == Token::Type::IDENTIFIER || GetToken()->type == Token::Type::DOT) {
-					nameTok.val += GetToken()->val;
+					JoinToken(nameTok, *GetToken());
 					NextToken();
 				}
 
 				if (GetToken()->type == Token::Type::OPEN_PARENTH) {
 					NextToken();
-					std::vector<Expression *> params;
+					ArenaVector<Expression *> params(&arena);
 
 					if (GetToken()->type == Token::Type::CLOSED_PARENTH) {
 						NextToken();
-						return new FuncCallExpr(nameTok, std::vector<Expression *>());
+						return arena.New<FuncCallExpr>(nameTok, ArenaVector<Expression *>(&arena));
 					}
 					while (true) {
 						auto expr = ParseExpression();
 						if (!expr) {
 							std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Invalid parameter n" << params.size() + 1 << "' at line " << GetToken()->row << "[" << GetToken()->col << "]\n";
 							errCode = RespCode::ERR;
-							for (auto param : params) delete param;
-
 							return nullptr;
 						}
 
@@ -309,8 +361,6 @@ namespace mlang {
 						if (GetToken()->type != Token::Type::CLOSED_PARENTH) {
 							std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Invalid value '" << GetToken()->val << "' at line " << GetToken()->row << "[" << GetToken()->col << "]\n";
 							errCode = RespCode::ERR;
-							for (auto param : params) delete param;
-
 							return nullptr;
 						}
 
@@ -318,14 +368,14 @@ namespace mlang {
 						break;
 					}
 
-					return new FuncCallExpr(nameTok, params);
+					return arena.New<FuncCallExpr>(nameTok, std::move(params));
 				}
 
-				return new ValueExpr(nameTok);
+				return arena.New<ValueExpr>(nameTok);
 			}
 
 			GoToIndex(beginIdx);
-			return new ValueExpr(nameTok);
+			return arena.New<ValueExpr>(nameTok);
 		}
 
 		errCode = RespCode::ERR;
@@ -349,15 +399,13 @@ namespace mlang {
 		}
 		type->name = idenTok->val;
 
-		size_t typeSz = 0;
-
 		if ((tok = NextToken())->type != Token::Type::OPEN_BRACE) {
 			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Unexpected '" << tok->val << "' at line " << tok->row << "[" << tok->col << "]\n";
 			delete type;
 			return RespCode::ERR;
 		}
 
-		auto scope = engine->GetScope();
+		auto scope = currScope;
 		scope->RegisterType(type);
 
 		inMethod = true;
@@ -422,7 +470,8 @@ namespace mlang {
 				}
 				dynamic_cast<FuncStmt *>(funcStmt)->funcScope->parentFunc->methodVisibility = currentVisibility;
 				dynamic_cast<FuncStmt *>(funcStmt)->funcScope->parentFunc->isMethod = true;
-				type->AddMethod(name->val, dynamic_cast<FuncStmt *>(funcStmt)->funcScope->parentFunc);
+				dynamic_cast<FuncStmt *>(funcStmt)->funcScope->parentFunc->classType = type;
+				type->AddMethod(std::string(name->val), dynamic_cast<FuncStmt *>(funcStmt)->funcScope->parentFunc);
 
 				continue;
 			}
@@ -431,23 +480,7 @@ namespace mlang {
 				delete type;
 				return RespCode::ERR;
 			}
-			typeSz += memberType.value()->Size();
-
-			auto newType = new TypeInfo(
-				engine, engine->GenerateTID(),
-				memberType.value()->GetName(),
-				memberType.value()->Size(), false, typeSz - memberType.value()->Size(),
-				type, memberType.value()->isClass
-			);
-			for (auto &[name, obj] : memberType.value()->members) {
-				newType->members[name] = obj;
-			}
-			for (auto &[name, method] : memberType.value()->methods) {
-				newType->methods[name] = method;
-			}
-			newType->visibility = currentVisibility;
-
-			type->AddMember(name->val, newType);
+			type->AddMember(std::string(name->val), memberType.value(), currentVisibility);
 		}
 		inMethod = false;
 
@@ -457,8 +490,7 @@ namespace mlang {
 			return RespCode::ERR;
 		}
 		type->engine = engine;
-		type->typeSz = typeSz;
-		type->typeID = engine->GenerateTID();
+		classes.push_back(type);	// Given a TID once the module is linked
 
 		return RespCode::SUCCESS;
 	}
@@ -472,7 +504,7 @@ namespace mlang {
 		Token nameTok = *NextToken();
 
 		while (GetToken()->type == Token::Type::IDENTIFIER || GetToken()->type == Token::Type::DOT) {
-			nameTok.val += NextToken()->val;
+			JoinToken(nameTok, *NextToken());
 		}
 
 		Token *tok;
@@ -482,10 +514,10 @@ namespace mlang {
 			return nullptr;
 		}
 
-		std::vector<Expression *> params;
+		ArenaVector<Expression *> params(&arena);
 		if (GetToken()->type == Token::Type::CLOSED_PARENTH) {
 			NextToken();
-			return new FuncCallStmt(nameTok, params);
+			return arena.New<FuncCallStmt>(nameTok, std::move(params));
 		}
 
 		while (true) {
@@ -493,8 +525,6 @@ namespace mlang {
 			if (!expr) {
 				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Invalid parameter n" << params.size() + 1 << " at line " << GetToken()->row << "[" << GetToken()->col << "]\n";
 				errCode = RespCode::ERR;
-				for (auto param : params) delete param;
-
 				return nullptr;
 			}
 
@@ -506,8 +536,6 @@ namespace mlang {
 			if (GetToken()->type != Token::Type::CLOSED_PARENTH) {
 				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Invalid value '" << GetToken()->val << " at line " << GetToken()->row << "[" << GetToken()->col << "]\n";
 				errCode = RespCode::ERR;
-				for (auto param : params) delete param;
-
 				return nullptr;
 			}
 
@@ -515,7 +543,7 @@ namespace mlang {
 			break;
 		}
 
-		return new FuncCallStmt(nameTok, params);
+		return arena.New<FuncCallStmt>(nameTok, std::move(params));
 	}
 	Statement *Module::ParseFuncDecl() {
 		auto typeTok = NextToken();
@@ -536,14 +564,14 @@ namespace mlang {
 			errCode = RespCode::ERR;
 			return nullptr;
 		}
-		auto scope = engine->GetScope()->AddChild(static_cast<int>(Scope::Type::FUNCTION));
+		auto scope = currScope->AddChild(static_cast<int>(Scope::Type::FUNCTION));
 		if (inMethod) { scope->SetScopeType(Scope::Type::CLASS); }
 
-		engine->SetScope(scope);
+		currScope = scope;
 
 		auto params = ParseParams();
 		if (NextToken()->type != Token::Type::CLOSED_PARENTH) {
-			engine->SetScope(scope->parent);
+			currScope = scope->parent;
 			scope->parent->DeleteChildScope(scope);
 
 			errCode = RespCode::ERR;
@@ -554,7 +582,7 @@ namespace mlang {
 		if (GetToken()->type == Token::Type::CONST) {
 			if (!inMethod) {
 				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Unexpected 'const' specified at line " << GetToken()->row << "[" << GetToken()->col << "]\n";
-				engine->SetScope(scope->parent);
+				currScope = scope->parent;
 				scope->parent->DeleteChildScope(scope);
 
 				errCode = RespCode::ERR;
@@ -578,14 +606,16 @@ namespace mlang {
 		auto block = ParseBlock();
 		constMethod = lastConst;
 
-		auto ret = new FuncStmt(params, block, *currTok, Token(Token::Type::IDENTIFIER, idenTok->val));
+		auto ret = arena.New<FuncStmt>(std::move(params), block, *currTok, *idenTok);
 		ret->funcScope = scope;
 
-		auto scriptFunc = new ScriptFunc(idenTok->val, params.size(), ret, retType.value(), inMethod, nullptr, isConst);
+		auto scriptFunc = new ScriptFunc(std::string(idenTok->val), ret->params.size(), ret, retType.value(), inMethod, isConst);
+		scriptFunc->module = this;
 		scope->parentFunc = scriptFunc;
 
-		engine->SetScope(scope->parent);
-		engine->GetScope()->RegisterFunc(scriptFunc);
+		currScope = scope->parent;
+		currScope->RegisterFunc(scriptFunc);
+		functions.push_back(scriptFunc);
 
 		return ret;
 	}
@@ -602,20 +632,19 @@ namespace mlang {
 			return nullptr;
 		}
 
-		auto scope = engine->GetScope()->AddChild(engine->GetScope()->scopeType | static_cast<int>(Scope::Type::LOOP));
-		engine->SetScope(scope);
+		auto scope = currScope->AddChild(currScope->scopeType | static_cast<int>(Scope::Type::LOOP));
+		currScope = scope;
 		auto cond = ParseExpression();
 		if ((tok = NextToken())->type != Token::Type::CLOSED_PARENTH) {
 			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Expected ')' at line " << tok->row << "[" << tok->col << "]\n";
 			errCode = RespCode::ERR;
-			delete cond;
 			return nullptr;
 		}
 
 		auto then = ParseBlock();
-		engine->SetScope(scope->parent);
+		currScope = scope->parent;
 
-		auto ret = new WhileStmt(cond, then);
+		auto ret = arena.New<WhileStmt>(cond, then);
 		ret->scope = scope;
 
 		return ret;
@@ -632,38 +661,36 @@ namespace mlang {
 			return nullptr;
 		}
 
-		auto parentScope = engine->GetScope();
-		engine->SetScope(parentScope->AddChild(parentScope->scopeType | static_cast<int>(Scope::Type::LOOP)));
+		auto parentScope = currScope;
+		auto scope = parentScope->AddChild(parentScope->scopeType | static_cast<int>(Scope::Type::LOOP));
+		currScope = scope;
 
 		auto first = ParseStatement();
 		if ((tok = NextToken())->type != Token::Type::SEMICOLON) {
 			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Expected ';' at line " << tok->row << "[" << tok->col << "]\n";
 			errCode = RespCode::ERR;
-			delete first;
 			return nullptr;
 		}
 		auto second = ParseExpression();
 		if ((tok = NextToken())->type != Token::Type::SEMICOLON) {
 			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Expected ';' at line " << tok->row << "[" << tok->col << "]\n";
 			errCode = RespCode::ERR;
-			delete first;
-			delete second;
 			return nullptr;
 		}
 		auto third = ParseStatement();
 		if ((tok = NextToken())->type != Token::Type::CLOSED_PARENTH) {
 			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Expected ')' at line " << tok->row << "[" << tok->col << "]\n";
 			errCode = RespCode::ERR;
-			delete first;
-			delete second;
-			delete third;
 			return nullptr;
 		}
 
 		auto then = ParseBlock();
-		engine->SetScope(parentScope);
+		currScope = parentScope;
 
-		return new ForStmt(first, second, third, then);
+		auto ret = arena.New<ForStmt>(first, second, third, then);
+		ret->scope = scope;
+
+		return ret;
 	}
 	Statement *Module::ParseIf() {
 		if (NextToken()->type != Token::Type::IF) {
@@ -686,35 +713,34 @@ namespace mlang {
 		if ((tok = NextToken())->type != Token::Type::CLOSED_PARENTH) {
 			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Expected ')' at line " << tok->row << "[" << tok->col << "]\n";
 			errCode = RespCode::ERR;
-			delete condition;
 			return nullptr;
 		}
 
-		auto thenScope = engine->GetScope()->AddChild(engine->GetScope()->scopeType);
+		auto thenScope = currScope->AddChild(currScope->scopeType);
 
-		engine->SetScope(thenScope);
+		currScope = thenScope;
 		auto then = ParseBlock();
-		engine->SetScope(thenScope->parent);
+		currScope = thenScope->parent;
 
 		Statement *els = nullptr;
 		Scope *elseScope = nullptr;
 		if (GetToken()->type == Token::Type::ELSE) {
 			NextToken();
-			elseScope = engine->GetScope()->AddChild(engine->GetScope()->scopeType);
+			elseScope = currScope->AddChild(currScope->scopeType);
 
-			engine->SetScope(elseScope);
+			currScope = elseScope;
 			els = ParseBlock();
-			engine->SetScope(elseScope->parent);
+			currScope = elseScope->parent;
 		}
 
-		auto ret = new IfStmt(then, condition, els);
+		auto ret = arena.New<IfStmt>(then, condition, els);
 		ret->thenScope = thenScope;
 		ret->elseScope = elseScope;
 
 		return ret;
 	}
-	std::vector<Statement *>Module::ParseParams() {
-		std::vector<Statement *> params;
+	ArenaVector<Statement *>Module::ParseParams() {
+		ArenaVector<Statement *> params(&arena);
 
 		auto tok = GetToken();
 
@@ -729,11 +755,10 @@ namespace mlang {
 				return params;
 			}
 			if (tok->type == Token::Type::IDENTIFIER) {
-				if (engine->GetScope()->FindTypeInfoByName(tok->val).code != RespCode::SUCCESS) {
+				if (currScope->FindTypeInfoByName(tok->val).code != RespCode::SUCCESS) {
 					std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Invalid type specified: '" << tok->val << "' at line " << tok->row << "[" << tok->col << "]\n";
-					for (auto &param : params) delete param;
 					errCode = RespCode::ERR;
-					return {};
+					return ArenaVector<Statement *>(&arena);
 				}
 			}
 
@@ -748,15 +773,20 @@ namespace mlang {
 			if (tok->type != Token::Type::IDENTIFIER) { return params; }
 			auto idenTok = tok;
 
-			currParam = new VarDeclStmt(*typeTok, *idenTok, nullptr);
+			currParam = arena.New<VarDeclStmt>(*typeTok, *idenTok, nullptr);
 
 			if (!currParam) { return params; }
 
 			params.push_back(currParam);
-			auto typeFind = engine->GetScope()->FindTypeInfoByName(typeTok->val).data.value();
-			auto obj = new ScriptObject(engine, typeFind, (constVar ? ScriptObject::Modifier::CONST : static_cast<ScriptObject::Modifier>(0)));
+			auto typeFind = currScope->FindTypeInfoByName(typeTok->val).data.value();
+			auto obj = new ScriptObject(engine, typeFind, (constVar ? ScriptObject::Modifier::CONST : static_cast<ScriptObject::Modifier>(0)), false);
 			obj->identifier = idenTok->val;
-			engine->GetScope()->RegisterObject(obj);
+			if (currScope->RegisterObject(obj) != RespCode::SUCCESS) {
+				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Parameter name '" << idenTok->val << "' already reserved at line " << idenTok->row << "[" << idenTok->col << "]\n";
+				delete obj;
+				errCode = RespCode::ERR;
+				return ArenaVector<Statement *>(&arena);
+			}
 
 			currParam = nullptr;
 			if (currTok->type == Token::Type::COMMA) { NextToken(); }
@@ -775,7 +805,7 @@ namespace mlang {
 			return ParseStatement();
 		}
 
-		BlockStmt *stmt = new BlockStmt();
+		BlockStmt *stmt = arena.New<BlockStmt>(&arena);
 		Statement *subStmt = nullptr;
 		while (true) {
 			if (GetToken()->type == Token::Type::CLOSED_BRACE) {
@@ -886,7 +916,7 @@ namespace mlang {
 			return nullptr;
 		}
 
-		auto ret = new VarDeclStmt(*typeTok, *identTok, expr);
+		auto ret = arena.New<VarDeclStmt>(*typeTok, *identTok, expr);
 		ret->modifiers = mods;
 		return ret;
 	}
@@ -912,14 +942,14 @@ namespace mlang {
 		}
 		else if (assignType->type == Token::Type::DOT) {
 			auto newTok = *identTok;
-			newTok.val += '.';
+			JoinToken(newTok, *assignType);
 			Token *tok;
 			while (true) {
 				if ((tok = NextToken())->type != Token::Type::DOT && tok->type != Token::Type::IDENTIFIER) {
 					break;
 				}
 
-				newTok.val += tok->val;
+				JoinToken(newTok, *tok);
 			}
 			*identTok = newTok;
 		}
@@ -931,15 +961,15 @@ namespace mlang {
 		}
 
 		if (assignType->type != Token::Type::ASSIGN && assignType->type != Token::Type::DOT) {
-			expr = new BinaryExpr(new ValueExpr(*identTok), Token(assignToOP.at(assignType->type)), expr);
+			expr = arena.New<BinaryExpr>(arena.New<ValueExpr>(*identTok), Token(assignToOP.at(assignType->type)), expr);
 		}
 
-		return new VarAssignStmt(*identTok, expr);
+		return arena.New<VarAssignStmt>(*identTok, expr);
 	}
 	Statement *Module::ParseStatement() {
 		auto beginIdx = currTokIdx;	// Makes sure to go back to the beginning of the statement
 		auto tok = GetToken();
-		auto type = engine->GetScope()->FindTypeInfoByName(tok->val);
+		auto type = currScope->FindTypeInfoByName(tok->val);
 		if ((tok->type >= Token::Type::TYPES_BEGIN && tok->type <= Token::Type::TYPES_END) ||
 			tok->type == Token::Type::UNSIGNED || tok->type == Token::Type::CONST || type.code == RespCode::SUCCESS) {
 			if (tok->type == Token::Type::CLASS) {
@@ -1001,29 +1031,29 @@ namespace mlang {
 		}
 		else if (tok->type == Token::Type::RETURN) {
 			NextToken();
-			if (!engine->GetScope()->IsOfType(Scope::Type::FUNCTION)) {
+			if (!currScope->IsOfType(Scope::Type::FUNCTION)) {
 				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Return not in function at line " << tok->row << "[" << tok->col << "]\n";
 				errCode = RespCode::ERR;
 				return nullptr;
 			}
 			auto toRet = ParseExpression();
-			return new ReturnStmt(toRet);
+			return arena.New<ReturnStmt>(toRet);
 		}
 		else if (tok->type == Token::Type::BREAK) {
 			NextToken();
-			if (!engine->GetScope()->IsOfType(Scope::Type::LOOP)) {
+			if (!currScope->IsOfType(Scope::Type::LOOP)) {
 				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Break not in loop at line " << tok->row << "[" << tok->col << "]\n";
 				errCode = RespCode::ERR;
 				return nullptr;
 			}
 			auto tok = NextToken();
-			if (NextToken()->type != Token::Type::SEMICOLON) {
+			if (tok->type != Token::Type::SEMICOLON) {
 				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Expected ';' specified at line " << tok->row << "[" << tok->col << "]\n";
 				errCode = RespCode::ERR;
 				return nullptr;
 			}
 
-			return new BreakStmt();
+			return arena.New<BreakStmt>();
 		}
 		if (tok->type == Token::Type::END) return nullptr;
 
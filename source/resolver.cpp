@@ -0,0 +1,343 @@
+#include <marklang.h>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+
+#ifndef __FUNCTION_NAME__
+	#if defined(WIN32) || defined(_WIN32)
+	#ifdef __PRETTY_FUNCTION__
+		#define __FUNCTION_NAME__  __PRETTY_FUNCTION__
+	#else
+		#define __FUNCTION_NAME__  __FUNCTION__
+	#endif
+#else
+	#define __FUNCTION_NAME__  __func__
+	#endif
+#endif
+
+namespace mlang {
+	// Resolution errors are kept in the binding and only reported if the code runs
+	template<typename... Args>
+	static std::string Format(const Args &...args) {
+		std::ostringstream stream;
+		(stream << ... << args);
+		return stream.str();
+	}
+
+	static size_t Align(size_t offset, size_t alignment) {
+		return (offset + alignment - 1) / alignment * alignment;
+	}
+	// Reserves room for a local in the frame of the function being resolved
+	static size_t AllocateLocal(size_t &frameSize, const TypeInfo *type) {
+		size_t alignment = (type->IsClass() || type->Size() > 8 ? 8 : std::max<size_t>(type->Size(), 1));
+
+		auto offset = Align(frameSize, alignment);
+		frameSize = offset + type->Size();
+		return offset;
+	}
+
+	static std::vector<std::string> SplitPath(std::string_view name) {
+		std::vector<std::string> ret;
+
+		size_t last = 0, pos;
+		while ((pos = name.find('.', last)) != std::string_view::npos) {
+			ret.emplace_back(name.substr(last, pos - last));
+			last = pos + 1;
+		}
+		ret.emplace_back(name.substr(last));
+
+		return ret;
+	}
+
+	Binding Module::ResolveName(const Token &name, Scope *scope, bool isCall) {
+		Binding ret;
+
+		auto path = SplitPath(name.val);
+		auto &root = path.front();
+		auto rootSym = (path.size() == 1 ? name.sym : engine->Symbols().Intern(root));
+
+		// Objects in the scope chain, members of the method's class once its scope is passed
+		bool inFrame = (currFunc != nullptr);
+		for (auto curr = scope; curr && ret.kind == Binding::Kind::UNRESOLVED; curr = curr->parent) {
+			auto slot = curr->FindObjectSlot(rootSym);
+			if (slot.code == RespCode::SUCCESS) {
+				auto obj = curr->objects[slot.data.value()];
+
+				ret.kind = Binding::Kind::OBJECT;
+				if (inFrame) {
+					ret.base = Binding::Base::FRAME;
+					ret.offset = obj->frameOffset;
+				}
+				else if (obj->module == this) {
+					ret.base = Binding::Base::GLOBAL;
+					ret.offset = obj->frameOffset;
+				}
+				else {
+					// Other modules' objects are copied into every context that reaches them
+					ret.module = obj->module;
+					ret.offset = obj->frameOffset;
+				}
+				ret.type = obj->GetType();
+				ret.isConst = obj->IsModifier(ScriptObject::Modifier::CONST);
+				break;
+			}
+
+			if (!currFunc || curr != currFunc->func->funcScope) continue;
+			inFrame = false;
+			if (!currFunc->classType) continue;
+
+			if (auto member = currFunc->classType->GetMember(root)) {
+				ret.kind = Binding::Kind::OBJECT;
+				ret.base = Binding::Base::THIS;
+				ret.offset = member.value()->offset;
+				ret.type = member.value()->type;
+				ret.isConst = currFunc->isConstMethod;
+				ret.isPublic = member.value()->visibility == TypeInfo::Visibility::PUBLIC;
+			}
+			else if (auto method = currFunc->classType->GetMethod(root); method && isCall && path.size() == 1) {
+				ret.kind = Binding::Kind::METHOD;
+				ret.base = Binding::Base::THIS;
+				ret.type = currFunc->classType;
+				ret.func = method.value();
+				ret.isConst = currFunc->isConstMethod;
+			}
+		}
+
+		if (ret.kind == Binding::Kind::UNRESOLVED && isCall && path.size() == 1) {
+			if (auto func = scope->FindFunc(rootSym); func.code == RespCode::SUCCESS) {
+				ret.kind = Binding::Kind::FUNCTION;
+				ret.func = func.data.value();
+			}
+		}
+
+		// Members are laid out flat inside the object, the path only adds offsets
+		for (size_t i = 1; i < path.size() && ret.kind == Binding::Kind::OBJECT; ++i) {
+			if (!ret.type->IsClass()) {
+				ret.kind = Binding::Kind::UNRESOLVED;
+				break;
+			}
+
+			if (auto member = ret.type->GetMember(path[i])) {
+				ret.offset += member.value()->offset;
+				ret.type = member.value()->type;
+				ret.isPublic = ret.isPublic && member.value()->visibility == TypeInfo::Visibility::PUBLIC;
+			}
+			else if (auto method = ret.type->GetMethod(path[i]); method && isCall && i == path.size() - 1) {
+				ret.kind = Binding::Kind::METHOD;
+				ret.func = method.value();
+			}
+			else {
+				ret.kind = Binding::Kind::UNRESOLVED;
+			}
+		}
+
+		if (isCall && ret.kind != Binding::Kind::FUNCTION && ret.kind != Binding::Kind::METHOD) {
+			ret.kind = Binding::Kind::UNRESOLVED;
+			ret.error = Format(__FUNCTION_NAME__, " ", __LINE__, " Invalid function '", name.val, "' at line ", name.row, "[", name.col, "]\n");
+		}
+		else if (!isCall && ret.kind != Binding::Kind::OBJECT) {
+			ret.kind = Binding::Kind::UNRESOLVED;
+			ret.error = Format(__FUNCTION_NAME__, " ", __LINE__, " Invalid object '", name.val, "' at line ", name.row, "[", name.col, "]\n");
+		}
+
+		return ret;
+	}
+
+	void Module::ResolveExpr(Expression *expr, Scope *scope) {
+		if (!expr) return;
+
+		switch (expr->type) {
+			case Expression::Type::VALUE: {
+				auto casted = static_cast<ValueExpr *>(expr);
+				if (casted->val.type != Token::Type::IDENTIFIER) return;
+
+				casted->binding = ResolveName(casted->val, scope, false);
+				return;
+			}
+			case Expression::Type::BINARY: {
+				auto casted = static_cast<BinaryExpr *>(expr);
+
+				ResolveExpr(casted->lhs, scope);
+				ResolveExpr(casted->rhs, scope);
+				return;
+			}
+			case Expression::Type::FUNCCALL: {
+				auto casted = static_cast<FuncCallExpr *>(expr);
+
+				for (auto param : casted->params) {
+					ResolveExpr(param, scope);
+				}
+				casted->binding = ResolveName(casted->funcName, scope, true);
+				CheckCall(casted->binding, casted->funcName);
+				return;
+			}
+			default:
+				return;
+		}
+	}
+
+	void Module::CheckCall(Binding &binding, const Token &name) {
+		if (!binding.error.empty() || binding.kind != Binding::Kind::METHOD) return;
+
+		auto func = binding.func;
+		bool thisBased = binding.base == Binding::Base::THIS;
+		bool onThis = thisBased && binding.type == currFunc->classType;
+
+		if (thisBased && currFunc->isConstMethod && !func->isConstMethod) {
+			binding.error = Format(__FUNCTION_NAME__, " ", __LINE__, " Call to non const function '", name.val, "' at line ", name.row, "[", name.col, "]\n");
+		}
+		else if (!thisBased && binding.isConst && !func->isConstMethod) {
+			binding.error = Format(
+				__FUNCTION_NAME__, " ", __LINE__, " Calling non const function '", name.val, "' of const object '", name.val.substr(0, name.val.find('.')),
+				"' at line ", name.row, "[", name.col, "]\n"
+			);
+		}
+		else if (!onThis && func->methodVisibility != TypeInfo::Visibility::PUBLIC) {
+			binding.error = Format(__FUNCTION_NAME__, " ", __LINE__, " Inacessible method '", name.val, "' at line ", name.row, "[", name.col, "]\n");
+		}
+	}
+	void Module::CheckStore(Binding &binding, const Token &name) {
+		if (!binding.error.empty()) return;
+
+		if (binding.base == Binding::Base::THIS && currFunc->isConstMethod) {
+			binding.error = Format(
+				__FUNCTION_NAME__, " ", __LINE__, " Assigning a member in constant method '", currFunc->GetName(), "' at line ", name.row, "[", name.col, "]\n"
+			);
+		}
+		else if (binding.isConst) {
+			binding.error = Format(__FUNCTION_NAME__, " ", __LINE__, " Assigning a value to a const object '", name.val, "' at line ", name.row, "[", name.col, "]\n");
+		}
+		else if (!binding.isPublic && (!currFunc || !currFunc->isMethod)) {
+			binding.error = Format(__FUNCTION_NAME__, " ", __LINE__, " Inacessible member '", name.val, "' at line ", name.row, "[", name.col, "]\n");
+		}
+	}
+
+	void Module::ResolveStmt(Statement *stmt, Scope *scope) {
+		if (!stmt) return;
+
+		switch (stmt->type) {
+			case Statement::Type::BLOCK: {
+				for (auto subStmt : static_cast<BlockStmt *>(stmt)->stmts) {
+					ResolveStmt(subStmt, scope);
+				}
+				return;
+			}
+			case Statement::Type::VARDECL: {
+				auto casted = static_cast<VarDeclStmt *>(stmt);
+				auto &ident = casted->ident;
+
+				ResolveExpr(casted->expr, scope);
+
+				if (scope->FindObject(ident.sym).code == RespCode::SUCCESS) {
+					casted->binding.error = Format(
+						__FUNCTION_NAME__, " ", __LINE__, " Variable name '", ident.val, "' already reserved at line ", ident.row, "[", ident.col, "]\n"
+					);
+					return;
+				}
+
+				auto typeFind = scope->FindTypeInfoByName(casted->type.val);
+				if (typeFind.code != RespCode::SUCCESS) {
+					casted->binding.error = Format(
+						__FUNCTION_NAME__, " ", __LINE__, " Type '", casted->type.val, "' not found at line ", ident.row, "[", ident.col, "]\n"
+					);
+					return;
+				}
+
+				// Module level objects get a place in each context's globals, function locals in the call frame
+				auto obj = new ScriptObject(engine, typeFind.data.value(), static_cast<ScriptObject::Modifier>(casted->modifiers), false);
+				obj->identifier = ident.val;
+				scope->RegisterObject(obj);
+
+				casted->binding.kind = Binding::Kind::OBJECT;
+				casted->binding.type = obj->GetType();
+				if (currFunc) {
+					obj->frameOffset = AllocateLocal(frameSize, obj->GetType());
+					casted->binding.base = Binding::Base::FRAME;
+				}
+				else {
+					obj->frameOffset = AllocateLocal(globalsSize, obj->GetType());
+					obj->module = this;
+					globals.push_back(obj);
+					casted->binding.base = Binding::Base::GLOBAL;
+				}
+				casted->binding.offset = obj->frameOffset;
+				return;
+			}
+			case Statement::Type::ASSIGNEMENT: {
+				auto casted = static_cast<VarAssignStmt *>(stmt);
+
+				ResolveExpr(casted->expr, scope);
+				casted->binding = ResolveName(casted->ident, scope, false);
+				CheckStore(casted->binding, casted->ident);
+				return;
+			}
+			case Statement::Type::FUNCCALL: {
+				auto casted = static_cast<FuncCallStmt *>(stmt);
+
+				for (auto param : casted->params) {
+					ResolveExpr(param, scope);
+				}
+				casted->binding = ResolveName(casted->funcName, scope, true);
+				CheckCall(casted->binding, casted->funcName);
+				return;
+			}
+			case Statement::Type::IF: {
+				auto casted = static_cast<IfStmt *>(stmt);
+
+				ResolveExpr(casted->condition, scope);
+				ResolveStmt(casted->then, casted->thenScope);
+				ResolveStmt(casted->els, casted->elseScope);
+				return;
+			}
+			case Statement::Type::WHILE: {
+				auto casted = static_cast<WhileStmt *>(stmt);
+
+				ResolveExpr(casted->cond, scope);
+				ResolveStmt(casted->then, casted->scope);
+				return;
+			}
+			case Statement::Type::FOR: {
+				auto casted = static_cast<ForStmt *>(stmt);
+
+				ResolveStmt(casted->start, casted->scope);
+				ResolveExpr(casted->cond, casted->scope);
+				ResolveStmt(casted->then, casted->scope);
+				ResolveStmt(casted->end, casted->scope);
+				return;
+			}
+			case Statement::Type::RETURN:
+				ResolveExpr(static_cast<ReturnStmt *>(stmt)->val, scope);
+				return;
+			case Statement::Type::BREAK:
+			case Statement::Type::FUNCDEF:
+				// Functions are resolved on their own
+				return;
+		}
+	}
+
+	void Module::Resolve() {
+		currFunc = nullptr;
+		for (auto stmt : moduleStmts->stmts) {
+			ResolveStmt(stmt, engine->GetScope());
+		}
+
+		for (auto func : functions) {
+			currFunc = func;
+			frameSize = 0;
+
+			// Parameters are the first objects of the function's scope
+			auto funcScope = func->func->funcScope;
+			func->params.clear();
+			for (size_t i = 0; i < func->func->params.size(); ++i) {
+				auto param = funcScope->objects[i];
+
+				param->frameOffset = AllocateLocal(frameSize, param->GetType());
+				func->params.push_back(ScriptFunc::Param{ param->GetType(), param->frameOffset });
+			}
+
+			ResolveStmt(func->func->block, funcScope);
+			func->frameSize = Align(frameSize, 8);
+		}
+		currFunc = nullptr;
+	}
+}
\ No newline at end of file
@@ -8,14 +8,15 @@ namespace mlang {
 		for (auto child : children) {
 			delete child;
 		}
-		for (auto type : types) {
-			delete type;
+		// Compiled functions reference types, they go first
+		for (auto func : funcs) {
+			delete func;
 		}
 		for (auto obj : objects) {
 			delete obj;
 		}
-		for (auto func : funcs) {
-			delete func;
+		for (auto type : types) {
+			delete type;
 		}
 	}
 
@@ -35,38 +36,48 @@ namespace mlang {
 	}
 
 	RespCode Scope::RegisterType(TypeInfo *type) {
-		if (std::find(types.begin(), types.end(), type) != types.end()) {
+		auto name = engine->Symbols().Intern(type->GetName());
+		if (typeIndices.contains(name)) {
 			return mlang::RespCode::ERR;
 		}
+		typeIndices[name] = types.size();
 		types.push_back(type);
 
 		return mlang::RespCode::SUCCESS;
 	}
 	RespCode Scope::RegisterObject(ScriptObject *obj) {
-		if (std::find(objects.begin(), objects.end(), obj) != objects.end()) {
+		auto name = engine->Symbols().Intern(obj->GetName());
+		if (objectIndices.contains(name)) {
 			return mlang::RespCode::ERR;
 		}
+		objectIndices[name] = objects.size();
 		objects.push_back(obj);
 
 		return mlang::RespCode::SUCCESS;
 	}
 	RespCode Scope::RegisterFunc(ScriptFunc *func) {
+		if (!func->isMethod) {
+			funcIndices.try_emplace(engine->Symbols().Intern(func->GetName()), funcs.size());
+		}
 		funcs.push_back(func);
 
 		return RespCode::SUCCESS;
 	}
 
-	Response<TypeInfo *> Scope::FindTypeInfoByName(const std::string &name) const {
-		auto pos = std::find_if(types.begin(), types.end(), [name](const TypeInfo *type) {
-			return type->GetName() == name;
-		});
-
-		if (pos != types.end()) {
-			return Response(*pos, RespCode::SUCCESS);
+	// Names that were never interned can't be registered anywhere
+	Response<TypeInfo *> Scope::FindTypeInfoByName(std::string_view name) const {
+		auto symbol = engine->Symbols().Find(name);
+		if (symbol.code != RespCode::SUCCESS) {
+			return Response<TypeInfo *>(nullptr, RespCode::ERR);
 		}
 
-		if (parent) {
-			return parent->FindTypeInfoByName(name);
+		return FindTypeInfo(symbol.data.value());
+	}
+	Response<TypeInfo *> Scope::FindTypeInfo(Symbol name) const {
+		for (auto curr = this; curr; curr = curr->parent) {
+			if (auto idx = curr->typeIndices.find(name); idx != curr->typeIndices.end()) {
+				return Response(curr->types[idx->second], RespCode::SUCCESS);
+			}
 		}
 
 		return Response<TypeInfo *>(nullptr, RespCode::ERR);
@@ -87,35 +98,47 @@ namespace mlang {
 		return Response<TypeInfo *>(nullptr, RespCode::ERR);
 	}
 
-	Response<ScriptObject *> Scope::FindObjectByName(const std::string &name) const {
-		auto pos = std::find_if(objects.begin(), objects.end(), [name](const ScriptObject *obj) {
-			return obj->GetName() == name;
-		});
-
-		if (pos != objects.end()) {
-			return Response(*pos, RespCode::SUCCESS);
+	Response<ScriptObject *> Scope::FindObjectByName(std::string_view name) const {
+		auto symbol = engine->Symbols().Find(name);
+		if (symbol.code != RespCode::SUCCESS) {
+			return Response<ScriptObject *>(nullptr, RespCode::ERR);
 		}
-		
-		if (parent) {
-			return parent->FindObjectByName(name);
+
+		return FindObject(symbol.data.value());
+	}
+	Response<ScriptObject *> Scope::FindObject(Symbol name) const {
+		for (auto curr = this; curr; curr = curr->parent) {
+			if (auto idx = curr->objectIndices.find(name); idx != curr->objectIndices.end()) {
+				return Response(curr->objects[idx->second], RespCode::SUCCESS);
+			}
 		}
 
-		return Response<ScriptObject *>(nullptr, RespCode::ERR);;
+		return Response<ScriptObject *>(nullptr, RespCode::ERR);
 	}
-	Response<ScriptFunc *> Scope::FindFuncByName(const std::string &name) const {
-		auto pos = std::find_if(funcs.begin(), funcs.end(), [name](const ScriptFunc *func) {
-			return func->GetName() == name;
-		});
+	Response<size_t> Scope::FindObjectSlot(Symbol name) const {
+		auto idx = objectIndices.find(name);
+		if (idx == objectIndices.end()) {
+			return Response<size_t>(RespCode::ERR);
+		}
 
-		if (pos != funcs.end()) {
-			return Response(*pos, RespCode::SUCCESS);
+		return Response<size_t>(idx->second, RespCode::SUCCESS);
+	}
+	Response<ScriptFunc *> Scope::FindFuncByName(std::string_view name) const {
+		auto symbol = engine->Symbols().Find(name);
+		if (symbol.code != RespCode::SUCCESS) {
+			return Response<ScriptFunc *>(nullptr, RespCode::ERR);
 		}
 
-		if (parent) {
-			return parent->FindFuncByName(name);
+		return FindFunc(symbol.data.value());
+	}
+	Response<ScriptFunc *> Scope::FindFunc(Symbol name) const {
+		for (auto curr = this; curr; curr = curr->parent) {
+			if (auto idx = curr->funcIndices.find(name); idx != curr->funcIndices.end()) {
+				return Response(curr->funcs[idx->second], RespCode::SUCCESS);
+			}
 		}
 
-		return Response<ScriptFunc *>(nullptr, RespCode::ERR);;
+		return Response<ScriptFunc *>(nullptr, RespCode::ERR);
 	}
 
 	static void PrintTabs(int tabs) {
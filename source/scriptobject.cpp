@@ -4,56 +4,35 @@
 #include <cstring>
 
 namespace mlang {
-	ScriptObject::ScriptObject(Engine *engine, const TypeInfo *type, Modifier mods, bool alloc, ScriptObject *parentClass)
-		: engine(engine), type(type), modifiers(mods), shouldDealloc(alloc), parentClass(parentClass) {
+	ScriptObject::ScriptObject(Engine *engine, const TypeInfo *type, Modifier mods, bool alloc)
+		: engine(engine), type(type), modifiers(mods), shouldDealloc(alloc) {
 		if (!IsModifier(Modifier::REFERENCE)) {
 			if (alloc) {
-				ptr = new char[type->Size()];
-			}
-
-			if (type->IsClass()) {
-				classScope = engine->GetScope()->AddChild(static_cast<int>(Scope::Type::CLASS));
-				for (auto &[memberName, memberType] : type->members) {
-					members[memberName] = new ScriptObject(engine, memberType, static_cast<Modifier>(0), false, parentClass);
-					if (alloc) {
-						members[memberName]->SetAddress(reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(ptr) + memberType->Offset()));
-					}
-					members[memberName]->identifier = memberName;
-					members[memberName]->parentClass = this;
-
-					classScope->RegisterObject(members[memberName]);
-				}
+				ptr = new char[type->Size()]();
 			}
 			refCount = 1;
 		}
 	}
-	ScriptObject::ScriptObject(Engine *engine, const TypeInfo *type, ScriptRval &rvalue, Modifier mods, bool alloc, ScriptObject *parentClass)
-		: ScriptObject(engine, type, mods, alloc, parentClass){
+	ScriptObject::ScriptObject(Engine *engine, const TypeInfo *type, ScriptRval &rvalue, Modifier mods, bool alloc)
+		: ScriptObject(engine, type, mods, alloc){
 		SetVal(rvalue);
 	}
 	ScriptObject::~ScriptObject() {
 		if (refCount) { refCount--; }
-		if (!IsModifier(Modifier::REFERENCE) && !refCount) {
-			for (auto &[ident, member] : members) {
-				//allocator.destroy(reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(ptr) + member->type->Offset()));
-			}
-			if (shouldDealloc) {
-				delete ptr;
-			}
+		if (!IsModifier(Modifier::REFERENCE) && !refCount && shouldDealloc) {
+			delete[] reinterpret_cast<char *>(ptr);
 		}
 	}
 
 	void ScriptObject::SetAddress(void *newPtr) {
 		ptr = newPtr;
-
-		for (auto &[name, member] : members) {
-			member->SetAddress(reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(ptr) + member->type->offset));
-		}
 	}
 
-	std::optional<ScriptObject *> ScriptObject::GetMember(const std::string &name) const {
-		if (!members.contains(name)) return std::nullopt;
-		return members.at(name);
+	std::optional<void *> ScriptObject::GetMemberAddress(const std::string &name) const {
+		auto member = type->GetMember(name);
+		if (!member) return std::nullopt;
+
+		return reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(ptr) + member.value()->offset);
 	}
 
 	RespCode ScriptObject::CallMethod(const std::string &name) {
@@ -64,280 +43,64 @@ namespace mlang {
 	}
 
 	RespCode ScriptObject::SetVal(ScriptRval &value) {
-		if (type->isClass ^ value.valueType->isClass) {
-			return RespCode::ERR;
-		}
-
-		if (value.reference) {
-			if (IsModifier(ScriptObject::Modifier::REFERENCE)) {
-				ptr = value.data;
-				return RespCode::SUCCESS;
-			}
-
-			auto retVal = SetVal(reinterpret_cast<const ScriptObject *>(value.data));
-
-			return retVal;
-		}
-
-		if (type->isClass) {
-			for (auto &[name, type] : value.valueType->members) {
-				if (members.at(name)->SetVal(reinterpret_cast<ScriptObject *>(reinterpret_cast<size_t>(value.data) + value.valueType->members.at(name)->offset)) != RespCode::SUCCESS) {
-					return RespCode::ERR;
-				}
-			}
-
-			return RespCode::SUCCESS;
-		}
-
-		bool thisFloat = type->name == "float" || type->name == "double";
-		bool otherFloat = value.valueType->name == "float" || value.valueType->name == "double";
-
-		if (thisFloat == otherFloat) {
-			// Simple memcpy for same types
-			if (type->Size() == value.valueType->Size()) {
-				memcpy(ptr, value.data, type->Size());
-				return RespCode::SUCCESS;
-			}
-			if (thisFloat) {
-				double srcVal = 0.0;
-				switch (value.valueType->Size()) {
-					case 4:
-						srcVal = static_cast<double>(*reinterpret_cast<float *>(value.data));
-						break;
-					case 8:
-						srcVal = static_cast<double>(*reinterpret_cast<float *>(value.data));
-						break;
-				}
-
-				switch (type->Size()) {
-					case 4:
-						*reinterpret_cast<float *>(ptr) = static_cast<float>(srcVal);
-						break;
-					case 8:
-						*reinterpret_cast<double *>(ptr) = static_cast<double>(srcVal);
-						break;
-				}
-
-				delete value.data;
-				value.data = nullptr;
-				return RespCode::SUCCESS;
-			}
-
-			uint64_t srcVal = 0;
-			switch (value.valueType->Size()) {
-				case 1:
-					srcVal = *reinterpret_cast<int8_t *>(value.data);
-					break;
-				case 2:
-					srcVal = *reinterpret_cast<int16_t *>(value.data);
-					break;
-				case 4:
-					srcVal = *reinterpret_cast<uint32_t *>(value.data);
-					break;
-				case 8:
-					srcVal = *reinterpret_cast<uint64_t *>(value.data);
-					break;
-			}
-
-			switch (type->Size()) {
-				case 1:
-					*reinterpret_cast<uint8_t *>(ptr) = static_cast<uint8_t>(srcVal);
-					break;
-				case 2:
-					*reinterpret_cast<uint16_t *>(ptr) = static_cast<uint16_t>(srcVal);
-					break;
-				case 4:
-					*reinterpret_cast<uint32_t *>(ptr) = static_cast<uint32_t>(srcVal);
-					break;
-				case 8:
-					*reinterpret_cast<uint64_t *>(ptr) = static_cast<uint64_t>(srcVal);
-					break;
+		if (value.reference && IsModifier(ScriptObject::Modifier::REFERENCE)) {
+			if (type->isClass ^ value.valueType->isClass) {
+				return RespCode::ERR;
 			}
 
+			ptr = value.data;
 			return RespCode::SUCCESS;
 		}
-		else if (otherFloat) {
-			float *floatPtr = reinterpret_cast<float *>(value.data);
-			double *doublePtr = reinterpret_cast<double *>(value.data);
 
-			switch (this->type->Size()) {
-				case 1:
-					*reinterpret_cast<uint8_t *>(ptr) = static_cast<uint8_t>((value.valueType->Size() == 4 ? *floatPtr : *doublePtr));
-					break;
-				case 2:
-					*reinterpret_cast<uint16_t *>(ptr) = static_cast<uint16_t>((value.valueType->Size() == 4 ? *floatPtr : *doublePtr));
-					break;
-				case 4:
-					*reinterpret_cast<uint32_t *>(ptr) = static_cast<uint32_t>((value.valueType->Size() == 4 ? *floatPtr : *doublePtr));
-					break;
-				case 8:
-					*reinterpret_cast<uint64_t *>(ptr) = static_cast<uint64_t>((value.valueType->Size() == 4 ? *floatPtr : *doublePtr));
-					break;
-			}
-		}
-		else {
-			uint64_t intSrc = 0;
-			switch (value.valueType->Size()) {
-				case 1:
-					intSrc = *reinterpret_cast<uint8_t *>(value.data);
-					break;
-				case 2:
-					intSrc = *reinterpret_cast<uint16_t *>(value.data);
-					break;
-				case 4:
-					intSrc = *reinterpret_cast<uint32_t *>(value.data);
-					break;
-				case 8:
-					intSrc = *reinterpret_cast<uint64_t *>(value.data);
-					break;
-			}
-
-			if (type->Size() == 4)
-				*static_cast<float *>(ptr) = static_cast<float>(value.valueType->unsig ? intSrc : static_cast<int64_t>(intSrc));
-			else
-				*static_cast<double *>(ptr) = static_cast<double>(value.valueType->unsig ? intSrc : static_cast<int64_t>(intSrc));
-		}
-		
-		return RespCode::SUCCESS;
+		return StoreVal(type, ptr, value);
 	}
-	RespCode ScriptObject::SetVal(const ScriptObject *value) {
-		if (type->isClass ^ value->type->isClass) {
+	RespCode ScriptObject::StoreVal(const TypeInfo *type, void *ptr, ScriptRval &value) {
+		return StoreFrom(type, ptr, value.valueType, value.data);
+	}
+	RespCode ScriptObject::StoreFrom(const TypeInfo *type, void *ptr, const TypeInfo *srcType, const void *src) {
+		if (type->isClass ^ srcType->isClass) {
 			return RespCode::ERR;
 		}
 
 		if (type->isClass) {
-			for (auto &[name, obj] : value->members) {
-				if ((members[name]->SetVal(obj) != RespCode::SUCCESS)) {
-					return RespCode::ERR;
-				}
+			if (type->TypeID() != srcType->TypeID()) {
+				return RespCode::ERR;
 			}
-			return RespCode::SUCCESS;
-		}
-
-		bool thisFloat = type->name == "float" || type->name == "double";
-		bool otherFloat = value->type->name == "float" || value->type->name == "double";
 
-		if (thisFloat == otherFloat) {
-			if (thisFloat) {
-				double srcVal = 0.0;
-				switch (value->type->Size()) {
-					case 4:
-						srcVal = static_cast<double>(*reinterpret_cast<float *>(value->ptr));
-						break;
-					case 8:
-						srcVal = static_cast<double>(*reinterpret_cast<float *>(value->ptr));
-						break;
-				}
-
-				switch (type->Size()) {
-					case 4:
-						*reinterpret_cast<float *>(ptr) = static_cast<float>(srcVal);
-						break;
-					case 8:
-						*reinterpret_cast<double *>(ptr) = static_cast<double>(srcVal);
-						break;
-				}
-
-				return RespCode::SUCCESS;
+			if (src != ptr) {
+				std::memmove(ptr, src, type->Size());
 			}
-
-			uint64_t srcVal = 0;
-			switch (value->type->Size()) {
-				case 1:
-					srcVal = *reinterpret_cast<int8_t*>(value->ptr);
-					break;
-				case 2:
-					srcVal = *reinterpret_cast<int16_t *>(value->ptr);
-					break;
-				case 4:
-					srcVal = *reinterpret_cast<uint32_t *>(value->ptr);
-					break;
-				case 8:
-					srcVal = *reinterpret_cast<uint64_t *>(value->ptr);
-					break;
-			}
-
-			switch (type->Size()) {
-				case 1:
-					*reinterpret_cast<uint8_t *>(ptr) = static_cast<uint8_t>(srcVal);
-					break;
-				case 2:
-					*reinterpret_cast<uint16_t *>(ptr) = static_cast<uint16_t>(srcVal);
-					break;
-				case 4:
-					*reinterpret_cast<uint32_t *>(ptr) = static_cast<uint32_t>(srcVal);
-					break;
-				case 8:
-					*reinterpret_cast<uint64_t *>(ptr) = static_cast<uint64_t>(srcVal);
-					break;
-			}
-
 			return RespCode::SUCCESS;
 		}
-		else if (!thisFloat) {
-			float *floatPtr = reinterpret_cast<float *>(value->ptr);
-			double *doublePtr = reinterpret_cast<double *>(value->ptr);
 
-			switch (this->type->Size()) {
-				case 1:
-					*reinterpret_cast<uint8_t *>(ptr) = static_cast<uint8_t>((value->type->Size() == 4 ? *floatPtr : *doublePtr));
-					break;
-				case 2:
-					*reinterpret_cast<uint16_t *>(ptr) = static_cast<uint16_t>((value->type->Size() == 4 ? *floatPtr : *doublePtr));
-					break;
-				case 4:
-					*reinterpret_cast<uint32_t *>(ptr) = static_cast<uint32_t>((value->type->Size() == 4 ? *floatPtr : *doublePtr));
-					break;
-				case 8:
-					*reinterpret_cast<uint64_t *>(ptr) = static_cast<uint64_t>((value->type->Size() == 4 ? *floatPtr : *doublePtr));
-					break;
+		// Simple memcpy for same types
+		if (type->Kind() == srcType->Kind()) {
+			if (src != ptr) {
+				std::memcpy(ptr, src, type->Size());
 			}
+			return RespCode::SUCCESS;
 		}
-		else if (otherFloat) {
-			uint64_t intSrc = 0;
-			switch (value->type->Size()) {
-				case 1:
-					intSrc = *reinterpret_cast<uint8_t *>(value->ptr);
-					break;
-				case 2:
-					intSrc = *reinterpret_cast<uint16_t *>(value->ptr);
-					break;
-				case 4:
-					intSrc = *reinterpret_cast<uint32_t *>(value->ptr);
-					break;
-				case 8:
-					intSrc = *reinterpret_cast<uint64_t *>(value->ptr);
-					break;
-			}
 
-			if (type->Size() == 4)
-				*static_cast<float *>(ptr) = static_cast<float>(value->type->unsig ? intSrc : static_cast<int64_t>(intSrc));
-			else
-				*static_cast<double *>(ptr) = static_cast<double>(value->type->unsig ? intSrc : static_cast<int64_t>(intSrc));
+		auto convert = GetConversion(srcType->Kind(), type->Kind());
+		if (!convert) {
+			return RespCode::ERR;
 		}
 
-
-		return RespCode::ERR;
+		convert(src, ptr);
+		return RespCode::SUCCESS;
+	}
+	RespCode ScriptObject::SetVal(const ScriptObject *value) {
+		return StoreFrom(type, ptr, value->type, value->ptr);
 	}
 
 	ScriptObject *ScriptObject::Clone(ScriptObject *original) {
-		auto ret = new ScriptObject(original->engine, original->type, original->modifiers, original->shouldDealloc, original->parentClass);
-		ret->classScope = original->classScope;
+		auto ret = new ScriptObject(original->engine, original->type, original->modifiers, original->shouldDealloc);
 
-		if (original->type->name == "char" ||
-			original->type->name == "short" ||
-			original->type->name == "int" ||
-			original->type->name == "long" ||
-			original->type->name == "float" ||
-			original->type->name == "double") {
-			ret->SetAddress(new char[original->type->Size()]);
-			std::memcpy(ret->GetAddressOfObj(), original->GetAddressOfObj(), original->type->Size());
-
-			return ret;
+		if (ret->ptr) {
+			std::memcpy(ret->ptr, original->ptr, original->type->Size());
 		}
-
-		for (auto &[name, member] : original->members) {
-			ret->members[name] = Clone(member);
+		else {
+			ret->ptr = original->ptr;
 		}
 
 		return ret;
@@ -1,801 +1,259 @@
 #include <marklang.h>
 #include <stdexcept>
 #include <utility>
+#include <array>
 
 namespace mlang {
-	ScriptRval::ScriptRval(ScriptRval &&other) noexcept
-		: engine(other.engine), valueType(other.valueType), reference(other.reference), data(std::exchange(other.data, nullptr)) {}
-	ScriptRval::ScriptRval(const ScriptRval &other)
-		: engine(other.engine), valueType(other.valueType), reference(other.reference) {
-		if (reference) {
-			data = other.data;
-			return;
-		}
-
-		if (!valueType->IsClass()) {
-			data = new char[valueType->Size()];
-			memcpy(data, other.data, valueType->Size());
-			return;
-		}
-		data = new ScriptObject(engine, valueType);
-		auto cast = reinterpret_cast<ScriptObject *>(data);
-		
-		for (auto &[name, member] : valueType->members) {
-			if (!member->IsClass()) {
-				memcpy(
-					reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(cast->ptr) + member->offset),
-					reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(cast->ptr) + member->offset),
-					member->Size()
-				);
-				continue;
-			}
-
-			cast->members[name] = ScriptObject::Clone(reinterpret_cast<ScriptObject *>(member));
+	// Numeric operators, one kernel per (lhs kind, rhs kind) pair generated at compile time
+	static constexpr size_t KindSize(NumericKind kind) {
+		switch (kind) {
+			case NumericKind::BOOL: case NumericKind::INT8: case NumericKind::UINT8: return 1;
+			case NumericKind::INT16: case NumericKind::UINT16: return 2;
+			case NumericKind::INT32: case NumericKind::UINT32: case NumericKind::FLOAT: return 4;
+			case NumericKind::INT64: case NumericKind::UINT64: case NumericKind::DOUBLE: return 8;
+			default: return 0;
 		}
 	}
-	ScriptRval ScriptRval::CreateFromLiteral(Engine *engine, const std::string &data) {
-		if (data.find('.') != std::string::npos) {
-			try {
-				auto type = engine->GetTypeInfoByName("float");
-
-				ScriptRval ret{engine, type};
-				ret.data = new float(std::stof(data));
-				return ret;
-			}
-			catch (std::out_of_range&) {
-				try {
-					auto type = engine->GetTypeInfoByName("double");
+	// Floating wins, then the bigger type, then unsigned. Bools count as int
+	static constexpr NumericKind Promote(NumericKind lhs, NumericKind rhs) {
+		if (lhs == NumericKind::BOOL) lhs = NumericKind::INT32;
+		if (rhs == NumericKind::BOOL) rhs = NumericKind::INT32;
+
+		if (lhs == NumericKind::DOUBLE || rhs == NumericKind::DOUBLE) return NumericKind::DOUBLE;
+		if (lhs == NumericKind::FLOAT || rhs == NumericKind::FLOAT) return NumericKind::FLOAT;
+		if (KindSize(lhs) != KindSize(rhs)) return (KindSize(lhs) > KindSize(rhs) ? lhs : rhs);
+		return (lhs >= NumericKind::UINT8 ? lhs : rhs);
+	}
 
-					ScriptRval ret{ engine, type };
-					ret.data = new double(std::stod(data));
-					return ret;
-				}
-				catch (std::out_of_range&) {
-					throw std::exception("Invalid literal size");
-				}
-			}
-			catch (...) {
-				throw std::exception("Invalid value found");
-			}
+	// Integers wrap around like their unsigned counterpart instead of overflowing
+	template<typename T, typename F>
+	static constexpr T Wrapping(T a, T b, F op) {
+		if constexpr (std::is_integral_v<T>) {
+			using Unsigned = std::make_unsigned_t<std::common_type_t<T, unsigned int>>;
+			return static_cast<T>(op(static_cast<Unsigned>(a), static_cast<Unsigned>(b)));
 		}
 		else {
-			try {
-				auto type = engine->GetTypeInfoByName("int");
-
-				ScriptRval ret{ engine, type };
-				ret.data = new int32_t(std::stoi(data));
-				return ret;
-				
-			}
-			catch (std::out_of_range&) {
-				try {
-					auto type = engine->GetTypeInfoByName("long");
-
-					ScriptRval ret{ engine, type };
-					ret.data = new int32_t(std::stoll(data));
-					return ret;
-				}
-				catch (std::out_of_range&) {
-					throw std::exception("Invalid literal size");
-				}
-			}
+			return op(a, b);
 		}
 	}
 
-	ScriptRval ScriptRval::operator+(const ScriptRval &other) const {
-		if (valueType->IsClass() || other.valueType->IsClass()) throw std::exception("Bad value type");
-		auto maxType = (valueType->Size() > other.valueType->Size() ? valueType : other.valueType);
-
-		if (maxType->GetName() != "float" && maxType->GetName() != "double") {
-			if (valueType->GetName() == "float" || valueType->GetName() == "double")
-				maxType = valueType;
-			else if (other.valueType->GetName() == "float" || other.valueType->GetName() == "double")
-				maxType = other.valueType;
-		}
-		
-		if (maxType->GetName() == "float" || maxType->GetName() == "double") {
-			double value = 0.0f;
-
-			if (valueType->GetName() == "float") {
-				value = *reinterpret_cast<float*>(data);
-			}
-			else if (valueType->GetName() == "double") {
-				value = *reinterpret_cast<double *>(data);
-			}
-			else {
-				switch (valueType->Size()) {
-					case 1:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-						break;
-					case 2:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(data) : *reinterpret_cast<int16_t *>(data));
-						break;
-					case 4:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(data) : *reinterpret_cast<int32_t *>(data));
-						break;
-					case 8:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(data) : *reinterpret_cast<int64_t *>(data));
-						break;
-				}
-			}
-
-			if (other.valueType->GetName() == "float") {
-				value += *reinterpret_cast<float *>(other.data);
-			}
-			else if (other.valueType->GetName() == "double") {
-				value += *reinterpret_cast<double *>(other.data);
-			}
-			else {
-				switch (other.valueType->Size()) {
-					case 1:
-						value += (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-						break;
-					case 2:
-						value += (other.valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(other.data) : *reinterpret_cast<int16_t *>(other.data));
-						break;
-					case 4:
-						value += (other.valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(other.data) : *reinterpret_cast<int32_t *>(other.data));
-						break;
-					case 8:
-						value += (other.valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(other.data) : *reinterpret_cast<int64_t *>(other.data));
-						break;
+	struct AddOp { static constexpr bool compares = false; template<typename T> static T Apply(T a, T b) { return Wrapping(a, b, std::plus<>()); } };
+	struct SubOp { static constexpr bool compares = false; template<typename T> static T Apply(T a, T b) { return Wrapping(a, b, std::minus<>()); } };
+	struct MulOp { static constexpr bool compares = false; template<typename T> static T Apply(T a, T b) { return Wrapping(a, b, std::multiplies<>()); } };
+	struct DivOp {
+		static constexpr bool compares = false;
+		template<typename T> static T Apply(T a, T b) {
+			if constexpr (std::is_integral_v<T>) {
+				if (b == 0) throw std::exception("Division by zero");
+				// The smallest value divided by -1 traps, it wraps around to itself instead
+				if constexpr (std::is_signed_v<T>) {
+					if (b == -1) return Wrapping(T(0), a, std::minus<>());
 				}
 			}
-
-			if (maxType->GetName() == "float") {
-				return ScriptRval::Create<float>(engine, maxType, value);
-			}
-			return ScriptRval::Create<double>(engine, maxType, value);
+			return a / b;
 		}
-		
-		uint64_t val = 0;
-		int64_t valSigned = 0;
+	};
+	struct LessOp { static constexpr bool compares = true; template<typename T> static bool Apply(T a, T b) { return a < b; } };
+	struct GreaterOp { static constexpr bool compares = true; template<typename T> static bool Apply(T a, T b) { return a > b; } };
+	struct LeqOp { static constexpr bool compares = true; template<typename T> static bool Apply(T a, T b) { return a <= b; } };
+	struct GeqOp { static constexpr bool compares = true; template<typename T> static bool Apply(T a, T b) { return a >= b; } };
+	struct EqOp { static constexpr bool compares = true; template<typename T> static bool Apply(T a, T b) { return a == b; } };
+	struct NeqOp { static constexpr bool compares = true; template<typename T> static bool Apply(T a, T b) { return a != b; } };
 
-		switch (valueType->Size()) {
-			case 1:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
-			case 2:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
-			case 4:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
-			case 8:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
-		}
+	struct KernelEntry {
+		Kernel kernel = nullptr;	// Null when either side isn't numeric
+		NumericKind result = NumericKind::NONE;
+	};
 
-		switch (other.valueType->Size()) {
-			case 1:
-				val += (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-			case 2:
-				val += (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-			case 4:
-				val += (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-			case 8:
-				val += (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-		}
+	template<typename Op, NumericKind L, NumericKind R>
+	static void Apply(const void *lhs, const void *rhs, void *out) {
+		using Common = typename KindType<Promote(L, R)>::Type;
 
-		if (maxType->IsUnsigned()) {
-			switch (maxType->Size()) {
-				case 1:
-					return ScriptRval::Create<uint8_t>(engine, maxType, val);
-				case 2:
-					return ScriptRval::Create<uint16_t>(engine, maxType, val);
-				case 4:
-					return ScriptRval::Create<uint32_t>(engine, maxType, val);
-				case 8:
-					return ScriptRval::Create<uint64_t>(engine, maxType, val);
-			}
+		auto a = static_cast<Common>(*static_cast<const typename KindType<L>::Type *>(lhs));
+		auto b = static_cast<Common>(*static_cast<const typename KindType<R>::Type *>(rhs));
+		if constexpr (Op::compares) {
+			*static_cast<bool *>(out) = Op::Apply(a, b);
 		}
-
-		switch (maxType->Size()) {
-			case 1:
-				return ScriptRval::Create<int8_t>(engine, maxType, val);
-			case 2:
-				return ScriptRval::Create<int16_t>(engine, maxType, val);
-			case 4:
-				return ScriptRval::Create<int32_t>(engine, maxType, val);
-			case 8:
-				return ScriptRval::Create<int64_t>(engine, maxType, val);
-			default:
-				throw std::exception("Invalid value type deduced");
+		else {
+			*static_cast<Common *>(out) = static_cast<Common>(Op::Apply(a, b));
 		}
 	}
-	ScriptRval ScriptRval::operator-(const ScriptRval &other) const {
-		if (valueType->IsClass() || other.valueType->IsClass()) throw std::exception("Bad value type");
-		auto maxType = (valueType->Size() > other.valueType->Size() ? valueType : other.valueType);
-
-		if (maxType->GetName() != "float" && maxType->GetName() != "double") {
-			if (valueType->GetName() == "float" || valueType->GetName() == "double")
-				maxType = valueType;
-			else if (other.valueType->GetName() == "float" || other.valueType->GetName() == "double")
-				maxType = other.valueType;
-		}
-
-		if (maxType->GetName() == "float" || maxType->GetName() == "double") {
-			double value = 0.0f;
-
-			if (valueType->GetName() == "float") {
-				value = *reinterpret_cast<float *>(data);
-			}
-			else if (valueType->GetName() == "double") {
-				value = *reinterpret_cast<double *>(data);
-			}
-			else {
-				switch (valueType->Size()) {
-					case 1:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-						break;
-					case 2:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(data) : *reinterpret_cast<int16_t *>(data));
-						break;
-					case 4:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(data) : *reinterpret_cast<int32_t *>(data));
-						break;
-					case 8:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(data) : *reinterpret_cast<int64_t *>(data));
-						break;
-				}
-			}
+	template<typename Op, size_t I>
+	static constexpr KernelEntry MakeKernel() {
+		constexpr auto lhs = static_cast<NumericKind>(I / numericKindCount);
+		constexpr auto rhs = static_cast<NumericKind>(I % numericKindCount);
 
-			if (other.valueType->GetName() == "float") {
-				value -= *reinterpret_cast<float *>(other.data);
-			}
-			else if (other.valueType->GetName() == "double") {
-				value -= *reinterpret_cast<double *>(other.data);
-			}
-			else {
-				switch (other.valueType->Size()) {
-					case 1:
-						value -= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-						break;
-					case 2:
-						value -= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(other.data) : *reinterpret_cast<int16_t *>(other.data));
-						break;
-					case 4:
-						value -= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(other.data) : *reinterpret_cast<int32_t *>(other.data));
-						break;
-					case 8:
-						value -= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(other.data) : *reinterpret_cast<int64_t *>(other.data));
-						break;
-				}
-			}
-
-			if (maxType->GetName() == "float") {
-				return ScriptRval::Create<float>(engine, maxType, value);
-			}
-			return ScriptRval::Create<double>(engine, maxType, value);
+		if constexpr (lhs == NumericKind::NONE || rhs == NumericKind::NONE) {
+			return KernelEntry{};
 		}
-
-		uint64_t val = 0;
-		int64_t valSigned = 0;
-
-		switch (valueType->Size()) {
-			case 1:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
-			case 2:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
-			case 4:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
-			case 8:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
-		}
-
-		switch (other.valueType->Size()) {
-			case 1:
-				val -= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-			case 2:
-				val -= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-			case 4:
-				val -= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-			case 8:
-				val -= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-		}
-
-		if (maxType->IsUnsigned()) {
-			switch (maxType->Size()) {
-				case 1:
-					return ScriptRval::Create<uint8_t>(engine, maxType, val);
-				case 2:
-					return ScriptRval::Create<uint16_t>(engine, maxType, val);
-				case 4:
-					return ScriptRval::Create<uint32_t>(engine, maxType, val);
-				case 8:
-					return ScriptRval::Create<uint64_t>(engine, maxType, val);
-			}
-		}
-
-		switch (maxType->Size()) {
-			case 1:
-				return ScriptRval::Create<int8_t>(engine, maxType, val);
-			case 2:
-				return ScriptRval::Create<int16_t>(engine, maxType, val);
-			case 4:
-				return ScriptRval::Create<int32_t>(engine, maxType, val);
-			case 8:
-				return ScriptRval::Create<int64_t>(engine, maxType, val);
-			default:
-				throw std::exception("Invalid value type deduced");
+		else {
+			return KernelEntry{ &Apply<Op, lhs, rhs>, (Op::compares ? NumericKind::BOOL : Promote(lhs, rhs)) };
 		}
 	}
-	ScriptRval ScriptRval::operator*(const ScriptRval &other) const {
-		if (valueType->IsClass() || other.valueType->IsClass()) throw std::exception("Bad value type");
-		auto maxType = (valueType->Size() > other.valueType->Size() ? valueType : other.valueType);
-
-		if (maxType->GetName() != "float" && maxType->GetName() != "double") {
-			if (valueType->GetName() == "float" || valueType->GetName() == "double")
-				maxType = valueType;
-			else if (other.valueType->GetName() == "float" || other.valueType->GetName() == "double")
-				maxType = other.valueType;
-		}
-
-		if (maxType->GetName() == "float" || maxType->GetName() == "double") {
-			double value = 0.0f;
-
-			if (valueType->GetName() == "float") {
-				value = *reinterpret_cast<float *>(data);
-			}
-			else if (valueType->GetName() == "double") {
-				value = *reinterpret_cast<double *>(data);
-			}
-			else {
-				switch (valueType->Size()) {
-					case 1:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-						break;
-					case 2:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(data) : *reinterpret_cast<int16_t *>(data));
-						break;
-					case 4:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(data) : *reinterpret_cast<int32_t *>(data));
-						break;
-					case 8:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(data) : *reinterpret_cast<int64_t *>(data));
-						break;
-				}
-			}
-
-			if (other.valueType->GetName() == "float") {
-				value *= *reinterpret_cast<float *>(other.data);
-			}
-			else if (other.valueType->GetName() == "double") {
-				value *= *reinterpret_cast<double *>(other.data);
-			}
-			else {
-				switch (other.valueType->Size()) {
-					case 1:
-						value *= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-						break;
-					case 2:
-						value *= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(other.data) : *reinterpret_cast<int16_t *>(other.data));
-						break;
-					case 4:
-						value *= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(other.data) : *reinterpret_cast<int32_t *>(other.data));
-						break;
-					case 8:
-						value *= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(other.data) : *reinterpret_cast<int64_t *>(other.data));
-						break;
-				}
-			}
+	template<typename Op, size_t... I>
+	static constexpr std::array<KernelEntry, sizeof...(I)> MakeKernels(std::index_sequence<I...>) {
+		return { MakeKernel<Op, I>()... };
+	}
+	template<typename Op>
+	static constexpr auto kernels = MakeKernels<Op>(std::make_index_sequence<numericKindCount * numericKindCount>());
+
+	template<typename Op>
+	static Kernel FindKernel(NumericKind lhs, NumericKind rhs, NumericKind &result) {
+		auto &entry = kernels<Op>[static_cast<size_t>(lhs) * numericKindCount + static_cast<size_t>(rhs)];
+		result = entry.result;
+		return entry.kernel;
+	}
+	Kernel GetKernel(OpCode op, NumericKind lhs, NumericKind rhs, NumericKind &result) {
+		switch (op) {
+			case OpCode::ADD: return FindKernel<AddOp>(lhs, rhs, result);
+			case OpCode::SUB: return FindKernel<SubOp>(lhs, rhs, result);
+			case OpCode::MUL: return FindKernel<MulOp>(lhs, rhs, result);
+			case OpCode::DIV: return FindKernel<DivOp>(lhs, rhs, result);
+			case OpCode::LESS: return FindKernel<LessOp>(lhs, rhs, result);
+			case OpCode::LEQ: return FindKernel<LeqOp>(lhs, rhs, result);
+			case OpCode::GREATER: return FindKernel<GreaterOp>(lhs, rhs, result);
+			case OpCode::GEQ: return FindKernel<GeqOp>(lhs, rhs, result);
+			case OpCode::EQ: return FindKernel<EqOp>(lhs, rhs, result);
+			case OpCode::NEQ: return FindKernel<NeqOp>(lhs, rhs, result);
+			default: break;
+		}
+
+		return nullptr;
+	}
 
-			if (maxType->GetName() == "float") {
-				return ScriptRval::Create<float>(engine, maxType, value);
-			}
-			return ScriptRval::Create<double>(engine, maxType, value);
-		}
+	template<typename Op>
+	ScriptRval ScriptRval::Compute(const ScriptRval &other) const {
+		auto &entry = kernels<Op>[static_cast<size_t>(valueType->Kind()) * numericKindCount + static_cast<size_t>(other.valueType->Kind())];
+		if (!entry.kernel) throw std::exception("Bad value type");
 
-		uint64_t val = 0;
-		int64_t valSigned = 0;
+		ScriptRval ret{ engine, engine->GetPrimitive(static_cast<Engine::Primitive>(entry.result)) };
+		ret.data = ret.inlineData;
+		entry.kernel(data, other.data, ret.inlineData);
+		return ret;
+	}
 
-		switch (valueType->Size()) {
-			case 1:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
-			case 2:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
-			case 4:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
-			case 8:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
+	ScriptRval::ScriptRval(ScriptRval &&other) noexcept
+		: engine(other.engine), valueType(other.valueType), reference(other.reference), data(std::exchange(other.data, nullptr)) {
+		if (data == other.inlineData) {
+			std::memcpy(inlineData, other.inlineData, sizeof(inlineData));
+			data = inlineData;
 		}
-
-		switch (other.valueType->Size()) {
-			case 1:
-				val *= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-			case 2:
-				val *= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-			case 4:
-				val *= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-			case 8:
-				val *= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
+	}
+	ScriptRval::ScriptRval(const ScriptRval &other)
+		: engine(other.engine), valueType(other.valueType), reference(other.reference) {
+		if (reference) {
+			data = other.data;
+			return;
 		}
 
-		if (maxType->IsUnsigned()) {
-			switch (maxType->Size()) {
-				case 1:
-					return ScriptRval::Create<uint8_t>(engine, maxType, val);
-				case 2:
-					return ScriptRval::Create<uint16_t>(engine, maxType, val);
-				case 4:
-					return ScriptRval::Create<uint32_t>(engine, maxType, val);
-				case 8:
-					return ScriptRval::Create<uint64_t>(engine, maxType, val);
-			}
+		if (!valueType->IsClass()) {
+			data = inlineData;
+			std::memcpy(inlineData, other.data, valueType->Size());
+			return;
 		}
 
-		switch (maxType->Size()) {
-			case 1:
-				return ScriptRval::Create<int8_t>(engine, maxType, val);
-			case 2:
-				return ScriptRval::Create<int16_t>(engine, maxType, val);
-			case 4:
-				return ScriptRval::Create<int32_t>(engine, maxType, val);
-			case 8:
-				return ScriptRval::Create<int64_t>(engine, maxType, val);
-			default:
-				throw std::exception("Invalid value type deduced");
-		}
+		// Objects are flat, copying the bytes copies every member
+		data = new char[valueType->Size()];
+		std::memcpy(data, other.data, valueType->Size());
 	}
-	ScriptRval ScriptRval::operator/(const ScriptRval &other) const {
-		if (valueType->IsClass() || other.valueType->IsClass()) throw std::exception("Bad value type");
-		auto maxType = (valueType->Size() > other.valueType->Size() ? valueType : other.valueType);
-
-		if (maxType->GetName() != "float" && maxType->GetName() != "double") {
-			if (valueType->GetName() == "float" || valueType->GetName() == "double")
-				maxType = valueType;
-			else if (other.valueType->GetName() == "float" || other.valueType->GetName() == "double")
-				maxType = other.valueType;
+	ScriptRval ScriptRval::CreateFromMemory(Engine *engine, const TypeInfo *type, void *ptr) {
+		// Class objects are passed around by reference
+		if (type->IsClass()) {
+			ScriptRval ret{ engine, type, true };
+			ret.data = ptr;
+			return ret;
 		}
 
-		if (maxType->GetName() == "float" || maxType->GetName() == "double") {
-			double value = 0.0f;
-
-			if (valueType->GetName() == "float") {
-				value = *reinterpret_cast<float *>(data);
-			}
-			else if (valueType->GetName() == "double") {
-				value = *reinterpret_cast<double *>(data);
-			}
-			else {
-				switch (valueType->Size()) {
-					case 1:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-						break;
-					case 2:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(data) : *reinterpret_cast<int16_t *>(data));
-						break;
-					case 4:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(data) : *reinterpret_cast<int32_t *>(data));
-						break;
-					case 8:
-						value = (valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(data) : *reinterpret_cast<int64_t *>(data));
-						break;
-				}
-			}
+		ScriptRval ret{ engine, type };
+		ret.data = ret.inlineData;
+		std::memcpy(ret.inlineData, ptr, type->Size());
+		return ret;
+	}
+	void ScriptRval::Detach() {
+		if (!reference || !valueType->IsClass()) return;
 
-			if (other.valueType->GetName() == "float") {
-				value /= *reinterpret_cast<float *>(other.data);
-			}
-			else if (other.valueType->GetName() == "double") {
-				value /= *reinterpret_cast<double *>(other.data);
-			}
-			else {
-				switch (other.valueType->Size()) {
-					case 1:
-						value /= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-						break;
-					case 2:
-						value /= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(other.data) : *reinterpret_cast<int16_t *>(other.data));
-						break;
-					case 4:
-						value /= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(other.data) : *reinterpret_cast<int32_t *>(other.data));
-						break;
-					case 8:
-						value /= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(other.data) : *reinterpret_cast<int64_t *>(other.data));
-						break;
-				}
-			}
+		auto copy = new char[valueType->Size()];
+		std::memcpy(copy, data, valueType->Size());
 
-			if (maxType->GetName() == "float") {
-				return ScriptRval::Create<float>(engine, maxType, value);
-			}
-			return ScriptRval::Create<double>(engine, maxType, value);
+		data = copy;
+		reference = false;
+	}
+	ScriptRval ScriptRval::CreateFromLiteral(Engine *engine, const std::string &data) {
+		auto literal = Literal::Parse(data);
+		if (!literal) {
+			throw std::exception("Invalid literal");
 		}
 
-		uint64_t val = 0;
-		int64_t valSigned = 0;
-
-		switch (valueType->Size()) {
-			case 1:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
-			case 2:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
-			case 4:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
-			case 8:
-				valSigned = val = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-				break;
+		return CreateFromLiteral(engine, literal.value());
+	}
+	ScriptRval ScriptRval::CreateFromLiteral(Engine *engine, const Literal &literal, const TypeInfo *as) {
+		auto literalType = engine->GetPrimitive(literal.type);
+		if (!as || as->IsClass()) {
+			as = literalType;
 		}
 
-		switch (other.valueType->Size()) {
-			case 1:
-				val /= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-			case 2:
-				val /= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-			case 4:
-				val /= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-			case 8:
-				val /= (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-				valSigned = val;
-				break;
-		}
+		ScriptRval ret{ engine, as };
+		ret.data = ret.inlineData;
 
-		if (maxType->IsUnsigned()) {
-			switch (maxType->Size()) {
-				case 1:
-					return ScriptRval::Create<uint8_t>(engine, maxType, val);
-				case 2:
-					return ScriptRval::Create<uint16_t>(engine, maxType, val);
-				case 4:
-					return ScriptRval::Create<uint32_t>(engine, maxType, val);
-				case 8:
-					return ScriptRval::Create<uint64_t>(engine, maxType, val);
-			}
+		// Every member of the union starts at the same address, the literal is converted once here instead of on every store
+		if (ScriptObject::StoreFrom(as, ret.inlineData, literalType, &literal.i64) != RespCode::SUCCESS) {
+			throw std::exception("Invalid literal conversion");
 		}
+		return ret;
+	}
 
-		switch (maxType->Size()) {
-			case 1:
-				return ScriptRval::Create<int8_t>(engine, maxType, val);
-			case 2:
-				return ScriptRval::Create<int16_t>(engine, maxType, val);
-			case 4:
-				return ScriptRval::Create<int32_t>(engine, maxType, val);
-			case 8:
-				return ScriptRval::Create<int64_t>(engine, maxType, val);
-			default:
-				throw std::exception("Invalid value type deduced");
-		}
+	ScriptRval ScriptRval::operator+(const ScriptRval &other) const {
+		return Compute<AddOp>(other);
+	}
+	ScriptRval ScriptRval::operator-(const ScriptRval &other) const {
+		return Compute<SubOp>(other);
+	}
+	ScriptRval ScriptRval::operator*(const ScriptRval &other) const {
+		return Compute<MulOp>(other);
+	}
+	ScriptRval ScriptRval::operator/(const ScriptRval &other) const {
+		return Compute<DivOp>(other);
 	}
 	
 	ScriptRval &ScriptRval::operator+=(const ScriptRval &other){
-		if (valueType->IsClass() || other.valueType->IsClass()) throw std::exception("Bad value type");
-		*this = std::move(*this + other);
+		*this = *this + other;
 		return *this;
 	}
 	ScriptRval &ScriptRval::operator-=(const ScriptRval &other){
-		if (valueType->IsClass() || other.valueType->IsClass()) throw std::exception("Bad value type");
 		*this = *this - other;
 		return *this;
 	}
 	ScriptRval &ScriptRval::operator*=(const ScriptRval &other){
-		if (valueType->IsClass() || other.valueType->IsClass()) throw std::exception("Bad value type");
 		*this = *this * other;
 		return *this;
 	}
 	ScriptRval &ScriptRval::operator/=(const ScriptRval &other){
-		if (valueType->IsClass() || other.valueType->IsClass()) throw std::exception("Bad value type");
 		*this = *this / other;
 		return *this;
 	}
 
 	ScriptRval ScriptRval::operator<(const ScriptRval &other) const {
-		if (valueType->IsClass() || other.valueType->IsClass()) throw std::exception("Bad value type");
-		bool value = false;
-		auto ret = ScriptRval::Create<bool>(engine, engine->GetTypeInfoByName("bool"), false);
-
-		return ret;
+		return Compute<LessOp>(other);
 	}
 	ScriptRval ScriptRval::operator>(const ScriptRval &other) const {
-		if (valueType->IsClass() || other.valueType->IsClass()) throw std::exception("Bad value type");
-		bool value = false;
-		auto ret = ScriptRval::Create<bool>(engine, engine->GetTypeInfoByName("bool"), false);
-
-		return ret;
+		return Compute<GreaterOp>(other);
 	}
 	ScriptRval ScriptRval::operator<=(const ScriptRval &other) const {
-		if (valueType->IsClass() || other.valueType->IsClass()) throw std::exception("Bad value type");
-		bool value = false;
-		auto ret = ScriptRval::Create<bool>(engine, engine->GetTypeInfoByName("bool"), false);
-
-		return ret;
+		return Compute<LeqOp>(other);
 	}
 	ScriptRval ScriptRval::operator>=(const ScriptRval &other) const {
-		if (valueType->IsClass() || other.valueType->IsClass()) throw std::exception("Bad value type");
-		bool value = false;
-		auto ret = ScriptRval::Create<bool>(engine, engine->GetTypeInfoByName("bool"), false);
-
-		return ret;
+		return Compute<GeqOp>(other);
 	}
 	ScriptRval ScriptRval::operator!=(const ScriptRval &other) const {
-		if (valueType->IsClass() || other.valueType->IsClass()) throw std::exception("Bad value type");
-		bool value = false;
-		auto ret = ScriptRval::Create<bool>(engine, engine->GetTypeInfoByName("bool"), false);
-
-		if (valueType->GetName() == "float") {
-			auto firstVal = *reinterpret_cast<float *>(data);
-
-			if (other.valueType->GetName() == "float") {
-				value = firstVal != *reinterpret_cast<float *>(other.data);
-			}
-			else if (other.valueType->GetName() == "double") {
-				value = firstVal != *reinterpret_cast<double *>(other.data);
-			}
-			else {
-				uint64_t secondVal = 0;
-				int64_t secondValSigned = 0;
-
-				switch (other.valueType->Size()) {
-					case 1:
-						secondVal = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-						secondValSigned = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-						break;
-					case 2:
-						secondVal = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(other.data) : *reinterpret_cast<int16_t *>(other.data));
-						secondValSigned = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(other.data) : *reinterpret_cast<int16_t *>(other.data));
-						break;
-					case 4:
-						secondVal = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(other.data) : *reinterpret_cast<int32_t *>(other.data));
-						secondValSigned = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(other.data) : *reinterpret_cast<int32_t *>(other.data));
-						break;
-					case 8:
-						secondVal = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(other.data) : *reinterpret_cast<int64_t *>(other.data));
-						secondValSigned = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(other.data) : *reinterpret_cast<int64_t *>(other.data));
-						break;
-				}
-
-				value = firstVal != (other.valueType->IsUnsigned() ? secondVal : secondValSigned);
-			}
-		}
-		else if (valueType->GetName() == "double") {
-			auto firstVal = *reinterpret_cast<double *>(data);
-
-			if (other.valueType->GetName() == "float") {
-				value = firstVal != *reinterpret_cast<float *>(other.data);
-			}
-			else if (other.valueType->GetName() == "double") {
-				value = firstVal != *reinterpret_cast<double *>(other.data);
-			}
-			else {
-				uint64_t secondVal = 0;
-				int64_t secondValSigned = 0;
-
-				switch (other.valueType->Size()) {
-					case 1:
-						secondVal = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-						secondValSigned = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-						break;
-					case 2:
-						secondVal = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(other.data) : *reinterpret_cast<int16_t *>(other.data));
-						secondValSigned = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(other.data) : *reinterpret_cast<int16_t *>(other.data));
-						break;
-					case 4:
-						secondVal = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(other.data) : *reinterpret_cast<int32_t *>(other.data));
-						secondValSigned = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(other.data) : *reinterpret_cast<int32_t *>(other.data));
-						break;
-					case 8:
-						secondVal = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(other.data) : *reinterpret_cast<int64_t *>(other.data));
-						secondValSigned = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(other.data) : *reinterpret_cast<int64_t *>(other.data));
-						break;
-				}
-
-				value = firstVal != (other.valueType->IsUnsigned() ? secondVal : secondValSigned);
-			}
-		}
-		else {
-			uint64_t firstVal = 0;
-			int64_t firstValSigned = 0;
-			
-			switch (valueType->Size()) {
-				case 1:
-					firstVal = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-					firstValSigned = (valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(data) : *reinterpret_cast<int8_t *>(data));
-					break;
-				case 2:
-					firstVal = (valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(data) : *reinterpret_cast<int16_t *>(data));
-					firstValSigned = (valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(data) : *reinterpret_cast<int16_t *>(data));
-					break;
-				case 4:
-					firstVal = (valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(data) : *reinterpret_cast<int32_t *>(data));
-					firstValSigned = (valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(data) : *reinterpret_cast<int32_t *>(data));
-					break;
-				case 8:
-					firstVal = (valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(data) : *reinterpret_cast<int64_t *>(data));
-					firstValSigned = (valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(data) : *reinterpret_cast<int64_t *>(data));
-					break;
-			}
-
-			if (other.valueType->GetName() == "float") {
-				float firstFloat = static_cast<float>(valueType->IsUnsigned() ? firstVal : firstValSigned);
-
-				value = firstFloat != *reinterpret_cast<float *>(other.data);
-			}
-			else if (other.valueType->GetName() == "double") {
-				float firstDouble = static_cast<double>(valueType->IsUnsigned() ? firstVal : firstValSigned);
-
-				value = firstDouble != *reinterpret_cast<double *>(other.data);
-			}
-			else {
-				uint64_t secondVal = 0;
-				int64_t secondValSigned = 0;
-
-				switch (other.valueType->Size()) {
-					case 1:
-						secondVal = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-						secondValSigned = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint8_t *>(other.data) : *reinterpret_cast<int8_t *>(other.data));
-						break;
-					case 2:
-						secondVal = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(other.data) : *reinterpret_cast<int16_t *>(other.data));
-						secondValSigned = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint16_t *>(other.data) : *reinterpret_cast<int16_t *>(other.data));
-						break;
-					case 4:
-						secondVal = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(other.data) : *reinterpret_cast<int32_t *>(other.data));
-						secondValSigned = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint32_t *>(other.data) : *reinterpret_cast<int32_t *>(other.data));
-						break;
-					case 8:
-						secondVal = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(other.data) : *reinterpret_cast<int64_t *>(other.data));
-						secondValSigned = (other.valueType->IsUnsigned() ? *reinterpret_cast<uint64_t *>(other.data) : *reinterpret_cast<int64_t *>(other.data));
-						break;
-				}
-
-				value = (valueType->IsUnsigned() ? firstVal : firstValSigned) != (other.valueType->IsUnsigned() ? secondVal : secondValSigned);
-			}
-		}
-
-		*reinterpret_cast<bool*>(ret.data) = value;
-		return ret;
+		return Compute<NeqOp>(other);
 	}
 	ScriptRval ScriptRval::operator==(const ScriptRval &other) const {
-		if (valueType->IsClass() || other.valueType->IsClass()) throw std::exception("Bad value type");
-		auto ret = (*this != other);
-
-		*reinterpret_cast<bool*>(ret.data) = !*reinterpret_cast<bool *>(ret.data);
-
-		return ret;
+		return Compute<EqOp>(other);
 	}
 
 	ScriptRval &ScriptRval::operator=(const ScriptRval &other) {
+		if (this == &other) return *this;
+
 		if (this->data) {
 			this->~ScriptRval();
 		}
@@ -809,25 +267,19 @@ namespace mlang {
 		}
 
 		if (!valueType->IsClass()) {
-			std::memcpy(this->data, other.data, valueType->Size());
+			data = inlineData;
+			std::memcpy(inlineData, other.data, valueType->Size());
 			return *this;
 		}
 
-		auto cast = new ScriptObject(engine, valueType);
-		data = cast;
-		for (auto &[name, member] : reinterpret_cast<ScriptObject *>(other.data)->members) {
-			if (member->IsModifier(ScriptObject::Modifier::REFERENCE)) {
-				cast->members[name] = new ScriptObject(engine, member->GetType(), member->modifiers, false);
-				cast->members[name]->ptr = member->ptr;
-				continue;
-			}
-
-			cast->members[name] = ScriptObject::Clone(member);
-		}
+		data = new char[valueType->Size()];
+		std::memcpy(data, other.data, valueType->Size());
 
 		return *this;
 	}
 	ScriptRval &ScriptRval::operator=(ScriptRval &&other) noexcept {
+		if (this == &other) return *this;
+
 		if (this->data) {
 			this->~ScriptRval();
 		}
@@ -836,25 +288,25 @@ namespace mlang {
 		this->valueType = other.valueType;
 		this->reference = other.reference;
 		this->data = std::exchange(other.data, nullptr);
+		if (data == other.inlineData) {
+			std::memcpy(inlineData, other.inlineData, sizeof(inlineData));
+			data = inlineData;
+		}
 
 		return *this;
 	}
 
 	ScriptRval::operator bool() const {
-		switch (valueType->Size()) {
-			case 1:
-				return *reinterpret_cast<uint8_t*>(data) != 0;
-			case 2:
-				return *reinterpret_cast<uint16_t *>(data) != 0;
-			case 4:
-				if (valueType->GetName() == "float")
-					return *reinterpret_cast<float *>(data) != 0;
-				return *reinterpret_cast<uint32_t *>(data) != 0;
-			case 8:
-				if (valueType->GetName() == "double")
-					return *reinterpret_cast<double *>(data) != 0;
-				return *reinterpret_cast<uint64_t *>(data) != 0;
+		switch (valueType->Kind()) {
+			case NumericKind::FLOAT:
+				return *reinterpret_cast<float *>(data) != 0;
+			case NumericKind::DOUBLE:
+				return *reinterpret_cast<double *>(data) != 0;
+			default:
+				// Integers, bools and objects are true if any byte is set
+				break;
 		}
+
 		for (size_t i = 0; i < valueType->Size(); ++i) {
 			if (reinterpret_cast<char *>(data)[i] != 0) {
 				return true;
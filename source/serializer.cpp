@@ -0,0 +1,653 @@
+#include <marklang.h>
+#include <iostream>
+#include <fstream>
+#include <cstring>
+
+#ifndef __FUNCTION_NAME__
+	#if defined(WIN32) || defined(_WIN32)
+	#ifdef __PRETTY_FUNCTION__
+		#define __FUNCTION_NAME__  __PRETTY_FUNCTION__
+	#else
+		#define __FUNCTION_NAME__  __FUNCTION__
+	#endif
+#else
+	#define __FUNCTION_NAME__  __func__
+	#endif
+#endif
+
+namespace mlang {
+	// Bumped whenever the layout below or the bytecode changes
+	static constexpr uint32_t compiledMagic = 0x43414c4d;	// "MLAC"
+	static constexpr uint32_t compiledVersion = 3;
+
+	// How a pointer to something of the engine is stored, local ones are indices into the module's lists
+	enum class RefKind : uint8_t {
+		NONE,
+		PRIMITIVE,	// Types only, by TID
+		LOCAL,
+		GLOBAL,		// By name
+		METHOD		// Functions only, by class and method name
+	};
+
+	struct Writer {
+		std::string buffer;
+
+		template<typename T>
+		void Write(const T &value) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			buffer.append(reinterpret_cast<const char *>(&value), sizeof(T));
+		}
+		void WriteString(std::string_view str) {
+			Write<uint32_t>(static_cast<uint32_t>(str.size()));
+			buffer.append(str);
+		}
+	};
+	// Reads past the end fail once and leave zeroes
+	struct Reader {
+		std::string_view data;
+		size_t pos = 0;
+		bool failed = false;
+
+		template<typename T>
+		T Read() {
+			static_assert(std::is_trivially_copyable_v<T>);
+			// Any byte is a valid bool
+			if constexpr (std::is_same_v<T, bool>) return Read<uint8_t>() != 0;
+
+			T ret{};
+			if (failed || data.size() - pos < sizeof(T)) {
+				failed = true;
+				return ret;
+			}
+
+			std::memcpy(&ret, data.data() + pos, sizeof(T));
+			pos += sizeof(T);
+			return ret;
+		}
+		std::string ReadString() {
+			auto size = Read<uint32_t>();
+			if (failed || data.size() - pos < size) {
+				failed = true;
+				return "";
+			}
+
+			std::string ret(data.substr(pos, size));
+			pos += size;
+			return ret;
+		}
+		// Count of things taking at least 'minSize' bytes each, there can't be more than what's left
+		uint32_t ReadCount(size_t minSize) {
+			auto count = Read<uint32_t>();
+			if (failed || count > (data.size() - pos) / minSize) {
+				failed = true;
+				return 0;
+			}
+
+			return count;
+		}
+	};
+
+	uint64_t Module::SourceHash() const {
+		// FNV-1a over every section and its length
+		uint64_t hash = 0xcbf29ce484222325ull;
+		auto mix = [&hash](const void *data, size_t size) {
+			for (size_t i = 0; i < size; ++i) {
+				hash ^= static_cast<const uint8_t *>(data)[i];
+				hash *= 0x100000001b3ull;
+			}
+		};
+
+		for (auto section : tokenizer.sections) {
+			uint64_t size = section.size();
+			mix(&size, sizeof(size));
+			mix(section.data(), section.size());
+		}
+		return hash;
+	}
+
+	RespCode Module::SaveCompiled(const std::string &file) const {
+		if (!context) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Module '" << name << "' isn't built\n";
+			return RespCode::ERR;
+		}
+
+		Writer out;
+		bool valid = true;
+
+		auto writeType = [&](const TypeInfo *type) {
+			if (!type) {
+				out.Write(RefKind::NONE);
+			}
+			else if (auto local = std::find(classes.begin(), classes.end(), type); local != classes.end()) {
+				out.Write(RefKind::LOCAL);
+				out.Write<uint32_t>(static_cast<uint32_t>(local - classes.begin()));
+			}
+			else if (type->TypeID() < static_cast<size_t>(Engine::Primitive::COUNT)) {
+				out.Write(RefKind::PRIMITIVE);
+				out.Write<uint32_t>(static_cast<uint32_t>(type->TypeID()));
+			}
+			else {
+				out.Write(RefKind::GLOBAL);
+				out.WriteString(type->GetName());
+			}
+		};
+		auto writeFunc = [&](const ScriptFunc *func) {
+			if (!func) {
+				out.Write(RefKind::NONE);
+			}
+			else if (auto local = std::find(functions.begin(), functions.end(), func); local != functions.end()) {
+				out.Write(RefKind::LOCAL);
+				out.Write<uint32_t>(static_cast<uint32_t>(local - functions.begin()));
+			}
+			else if (func->isMethod) {
+				out.Write(RefKind::METHOD);
+				out.WriteString(func->classType->GetName());
+				out.WriteString(func->GetName());
+			}
+			else {
+				out.Write(RefKind::GLOBAL);
+				out.WriteString(func->GetName());
+			}
+		};
+		auto writeCode = [&](const Bytecode &code) {
+			out.Write<uint32_t>(static_cast<uint32_t>(code.code.size()));
+			// Operators are saved as they were before quickening
+			for (auto &inst : code.code) {
+				out.Write(inst.Generic());
+				out.Write(inst.IsBinary() ? 0u : inst.arg);
+				out.Write(inst.arg2);
+			}
+
+			out.Write<uint32_t>(static_cast<uint32_t>(code.constants.size()));
+			for (auto &constant : code.constants) {
+				if (constant.valueType->IsClass()) valid = false;
+
+				writeType(constant.valueType);
+				out.buffer.append(static_cast<const char *>(constant.data), constant.valueType->Size());
+			}
+
+			out.Write<uint32_t>(static_cast<uint32_t>(code.bindings.size()));
+			for (auto &binding : code.bindings) {
+				// Objects of other modules are found again by name, the offset is kept from the object
+				const ScriptObject *owner = nullptr;
+				bool isStatic = binding.base == Binding::Base::STATIC && binding.kind != Binding::Kind::FUNCTION;
+				if (isStatic) {
+					auto &objects = engine->GetScope()->objects;
+					auto obj = std::find_if(objects.begin(), objects.end(), [&binding](const ScriptObject *obj) {
+						return obj->module == binding.module && binding.offset >= obj->frameOffset && binding.offset < obj->frameOffset + obj->GetType()->Size();
+					});
+					if (obj != objects.end()) owner = *obj;
+					else valid = false;
+				}
+
+				out.Write(binding.kind);
+				out.Write(binding.base);
+				out.Write(binding.isConst);
+				out.Write(binding.isPublic);
+				out.Write<uint64_t>(owner ? binding.offset - owner->frameOffset : binding.offset);
+				writeType(binding.type);
+				writeFunc(binding.func);
+
+				if (isStatic) out.WriteString(owner ? owner->GetName() : "");
+			}
+
+			out.Write<uint32_t>(static_cast<uint32_t>(code.errors.size()));
+			for (auto &error : code.errors) {
+				out.WriteString(error);
+			}
+		};
+
+		out.Write(compiledMagic);
+		out.Write(compiledVersion);
+		out.Write(SourceHash());
+
+		// Classes first, anything can refer to them
+		out.Write<uint32_t>(static_cast<uint32_t>(classes.size()));
+		for (auto type : classes) {
+			out.WriteString(type->GetName());
+		}
+		for (auto type : classes) {
+			out.Write<uint32_t>(static_cast<uint32_t>(type->members.size()));
+			for (auto &member : type->members) {
+				out.WriteString(member.name);
+				writeType(member.type);
+				out.Write(member.visibility);
+			}
+		}
+
+		out.Write<uint32_t>(static_cast<uint32_t>(functions.size()));
+		for (auto func : functions) {
+			out.WriteString(func->GetName());
+			writeType(func->returnType);
+			writeType(func->classType);
+			out.Write(func->isMethod);
+			out.Write(func->isConstMethod);
+			out.Write(func->methodVisibility);
+			out.Write<uint64_t>(func->frameSize);
+
+			out.Write<uint32_t>(static_cast<uint32_t>(func->params.size()));
+			for (auto &param : func->params) {
+				writeType(param.type);
+				out.Write<uint64_t>(param.offset);
+			}
+		}
+		for (auto type : classes) {
+			out.Write<uint32_t>(static_cast<uint32_t>(type->methods.size()));
+			for (auto &[methodName, method] : type->methods) {
+				out.WriteString(methodName);
+				writeFunc(method);
+			}
+		}
+
+		out.Write<uint64_t>(globalsSize);
+		out.Write<uint32_t>(static_cast<uint32_t>(globals.size()));
+		for (auto obj : globals) {
+			out.WriteString(obj->GetName());
+			writeType(obj->GetType());
+			out.Write(obj->modifiers);
+			out.Write<uint64_t>(obj->frameOffset);
+			// Objects in nested blocks aren't reachable from other modules
+			out.Write(engine->GetScope()->FindObjectByName(obj->GetName()).data == obj);
+		}
+
+		writeCode(moduleCode);
+		for (auto func : functions) {
+			writeCode(*func->code);
+		}
+
+		if (!valid) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Module '" << name << "' refers to something that can't be saved\n";
+			return RespCode::ERR;
+		}
+
+		std::ofstream fp(file, std::ios::binary | std::ios::trunc);
+		fp.write(out.buffer.data(), out.buffer.size());
+		if (!fp) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Couldn't write '" << file << "'\n";
+			return RespCode::ERR;
+		}
+		return RespCode::SUCCESS;
+	}
+
+	RespCode Module::LoadCompiled(const std::string &file) {
+		if (!toks.empty() || context) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Module '" << name << "' was already built\n";
+			return RespCode::ERR;
+		}
+
+		MappedFile mapped;
+		if (mapped.Open(file) != RespCode::SUCCESS) {
+			return RespCode::ERR;
+		}
+
+		Reader in{ mapped.View() };
+		if (in.Read<uint32_t>() != compiledMagic || in.Read<uint32_t>() != compiledVersion || in.Read<uint64_t>() != SourceHash()) {
+			// Outdated, the caller builds from source
+			return RespCode::ERR;
+		}
+
+		auto globalScope = engine->GetScope();
+
+		// Owned here until everything is read
+		std::vector<std::unique_ptr<TypeInfo>> loadedClasses;
+		std::vector<std::unique_ptr<ScriptFunc>> loadedFuncs;
+		std::vector<std::unique_ptr<ScriptObject>> loadedGlobals;
+		std::vector<bool> visible;
+
+		auto readType = [&]() -> TypeInfo * {
+			switch (in.Read<RefKind>()) {
+				case RefKind::NONE:
+					return nullptr;
+				case RefKind::PRIMITIVE: {
+					auto idx = in.Read<uint32_t>();
+					if (idx < static_cast<size_t>(Engine::Primitive::COUNT)) return engine->GetPrimitive(static_cast<Engine::Primitive>(idx));
+					break;
+				}
+				case RefKind::LOCAL: {
+					auto idx = in.Read<uint32_t>();
+					if (idx < loadedClasses.size()) return loadedClasses[idx].get();
+					break;
+				}
+				case RefKind::GLOBAL: {
+					auto type = globalScope->FindTypeInfoByName(in.ReadString());
+					if (type.code == RespCode::SUCCESS) return type.data.value();
+					break;
+				}
+				default:
+					break;
+			}
+
+			in.failed = true;
+			return nullptr;
+		};
+		auto readFunc = [&]() -> ScriptFunc * {
+			switch (in.Read<RefKind>()) {
+				case RefKind::NONE:
+					return nullptr;
+				case RefKind::LOCAL: {
+					auto idx = in.Read<uint32_t>();
+					if (idx < loadedFuncs.size()) return loadedFuncs[idx].get();
+					break;
+				}
+				case RefKind::GLOBAL: {
+					auto func = globalScope->FindFuncByName(in.ReadString());
+					if (func.code == RespCode::SUCCESS) return func.data.value();
+					break;
+				}
+				case RefKind::METHOD: {
+					auto type = globalScope->FindTypeInfoByName(in.ReadString());
+					auto method = in.ReadString();
+					if (type.code != RespCode::SUCCESS) break;
+
+					if (auto func = type.data.value()->GetMethod(method)) return func.value();
+					break;
+				}
+				default:
+					break;
+			}
+
+			in.failed = true;
+			return nullptr;
+		};
+		auto readCode = [&](Bytecode &code) {
+			code.code.resize(in.ReadCount(sizeof(OpCode) + 2 * sizeof(uint32_t)));
+			for (auto &inst : code.code) {
+				inst.op = in.Read<OpCode>();
+				inst.arg = in.Read<uint32_t>();
+				inst.arg2 = in.Read<uint32_t>();
+			}
+
+			auto constantCount = in.Read<uint32_t>();
+			for (uint32_t i = 0; i < constantCount && !in.failed; ++i) {
+				auto type = readType();
+				if (!type || type->IsClass()) {
+					in.failed = true;
+					break;
+				}
+
+				ScriptRval constant{ engine, type };
+				constant.data = constant.inlineData;
+				for (size_t byte = 0; byte < type->Size(); ++byte) {
+					constant.inlineData[byte] = in.Read<char>();
+				}
+				code.constants.push_back(std::move(constant));
+			}
+
+			code.bindings.resize(in.ReadCount(sizeof(Binding::Kind) + sizeof(Binding::Base) + 2 * sizeof(bool) + sizeof(uint64_t)));
+			for (auto &binding : code.bindings) {
+				binding.kind = in.Read<Binding::Kind>();
+				binding.base = in.Read<Binding::Base>();
+				binding.isConst = in.Read<bool>();
+				binding.isPublic = in.Read<bool>();
+				binding.offset = in.Read<uint64_t>();
+				binding.type = readType();
+				binding.func = readFunc();
+				if (binding.kind > Binding::Kind::METHOD || binding.base > Binding::Base::THIS) in.failed = true;
+
+				if (binding.base != Binding::Base::STATIC || binding.kind == Binding::Kind::FUNCTION || in.failed) continue;
+
+				auto obj = globalScope->FindObjectByName(in.ReadString());
+				if (obj.code != RespCode::SUCCESS || !obj.data.value()->module || obj.data.value()->module == this) {
+					in.failed = true;
+					continue;
+				}
+				binding.module = obj.data.value()->module;
+				binding.offset += obj.data.value()->frameOffset;
+			}
+
+			auto errorCount = in.Read<uint32_t>();
+			for (uint32_t i = 0; i < errorCount && !in.failed; ++i) {
+				code.errors.push_back(in.ReadString());
+			}
+		};
+		// Anyone can write the file, nothing in it may lead the VM out of bounds. Every index, jump and offset
+		// must be in range, and every path must agree on the stack's depth
+		auto verify = [&](const Bytecode &code, size_t frameSize, const TypeInfo *classType, size_t moduleGlobalsSize) {
+			auto fits = [](size_t offset, const TypeInfo *type, size_t size) {
+				return type && offset <= size && type->Size() <= size - offset;
+			};
+			auto validBinding = [&](uint32_t idx, bool isCall) {
+				if (idx >= code.bindings.size()) return false;
+
+				// Functions are called without an object, methods only on an object of their own class
+				auto &binding = code.bindings[idx];
+				if (binding.kind == Binding::Kind::FUNCTION) return isCall && binding.func && !binding.func->isMethod;
+				if (binding.kind == Binding::Kind::METHOD) {
+					if (!isCall || !binding.func || !binding.func->isMethod || !binding.type || !binding.type->IsClass() || binding.type != binding.func->classType) return false;
+				}
+				else if (binding.kind != Binding::Kind::OBJECT || isCall) {
+					return false;
+				}
+
+				switch (binding.base) {
+					case Binding::Base::FRAME: return fits(binding.offset, binding.type, frameSize);
+					case Binding::Base::GLOBAL: return fits(binding.offset, binding.type, moduleGlobalsSize);
+					case Binding::Base::THIS: return classType && fits(binding.offset, binding.type, classType->Size());
+					case Binding::Base::STATIC: return binding.module && fits(binding.offset, binding.type, binding.module->globalsSize);
+				}
+				return false;
+			};
+
+			if (code.code.empty()) return false;
+
+			// Stack depth before each instruction, -1 until it's reached
+			std::vector<int64_t> depths(code.code.size(), -1);
+			std::vector<size_t> pending{ 0 };
+			depths[0] = 0;
+			auto reach = [&](size_t target, int64_t depth) {
+				if (target >= code.code.size()) return false;
+				if (depths[target] < 0) {
+					depths[target] = depth;
+					pending.push_back(target);
+					return true;
+				}
+				return depths[target] == depth;
+			};
+
+			while (!pending.empty()) {
+				auto idx = pending.back();
+				pending.pop_back();
+
+				auto &inst = code.code[idx];
+				int64_t pops = 0, pushes = 0;
+				bool fallsThrough = true, jumps = false;
+				switch (inst.op) {
+					case OpCode::PUSH_CONST:
+						if (inst.arg >= code.constants.size()) return false;
+						pushes = 1;
+						break;
+					case OpCode::LOAD:
+						if (!validBinding(inst.arg, false)) return false;
+						pushes = 1;
+						break;
+					case OpCode::STORE:
+						if (!validBinding(inst.arg, false)) return false;
+						pops = 1;
+						break;
+					case OpCode::DECLARE:
+						if (!validBinding(inst.arg, false)) return false;
+						pops = (inst.arg2 ? 1 : 0);
+						break;
+					case OpCode::POP:
+						pops = 1;
+						break;
+					case OpCode::FAIL:
+						if (inst.arg >= code.errors.size()) return false;
+						fallsThrough = false;
+						break;
+					case OpCode::ADD:
+					case OpCode::SUB:
+					case OpCode::MUL:
+					case OpCode::DIV:
+					case OpCode::LESS:
+					case OpCode::LEQ:
+					case OpCode::GREATER:
+					case OpCode::GEQ:
+					case OpCode::EQ:
+					case OpCode::NEQ:
+						// Saved before quickening
+						if (inst.arg) return false;
+						pops = 2;
+						pushes = 1;
+						break;
+					case OpCode::JUMP:
+						jumps = true;
+						fallsThrough = false;
+						break;
+					case OpCode::JUMP_IF_FALSE:
+						jumps = true;
+						pops = 1;
+						break;
+					case OpCode::CALL:
+						if (!validBinding(inst.arg, true)) return false;
+						pops = inst.arg2;
+						pushes = 1;
+						break;
+					case OpCode::RETURN:
+						pops = 1;
+						fallsThrough = false;
+						break;
+					case OpCode::RETURN_VOID:
+					case OpCode::HALT:
+						fallsThrough = false;
+						break;
+					default:
+						return false;
+				}
+
+				auto depth = depths[idx];
+				if (depth < pops) return false;
+				depth += pushes - pops;
+
+				if (jumps && !reach(inst.arg, depth)) return false;
+				if (fallsThrough && !reach(idx + 1, depth)) return false;
+			}
+			return true;
+		};
+
+		auto classCount = in.Read<uint32_t>();
+		for (uint32_t i = 0; i < classCount && !in.failed; ++i) {
+			auto type = std::make_unique<TypeInfo>(engine, 0, in.ReadString(), 0, false, 0, nullptr, true);
+			if (globalScope->FindTypeInfoByName(type->GetName()).code == RespCode::SUCCESS) {
+				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Type '" << type->GetName() << "' already exists\n";
+				return RespCode::ERR;
+			}
+			loadedClasses.push_back(std::move(type));
+		}
+		for (auto &type : loadedClasses) {
+			auto memberCount = in.Read<uint32_t>();
+			for (uint32_t i = 0; i < memberCount && !in.failed; ++i) {
+				auto memberName = in.ReadString();
+				auto memberType = readType();
+				auto visibility = in.Read<TypeInfo::Visibility>();
+
+				// Laid out again the same way
+				if (!memberType || type->AddMember(memberName, memberType, visibility) != RespCode::SUCCESS) in.failed = true;
+			}
+		}
+
+		auto funcCount = in.Read<uint32_t>();
+		for (uint32_t i = 0; i < funcCount && !in.failed; ++i) {
+			auto funcName = in.ReadString();
+			auto returnType = readType();
+			auto func = std::make_unique<ScriptFunc>(funcName, 0, nullptr, returnType);
+			func->classType = readType();
+			func->isMethod = in.Read<bool>();
+			func->isConstMethod = in.Read<bool>();
+			func->methodVisibility = in.Read<TypeInfo::Visibility>();
+			func->frameSize = in.Read<uint64_t>();
+			func->code = std::make_unique<Bytecode>();
+			func->module = this;
+
+			func->paramCount = in.Read<uint32_t>();
+			for (size_t param = 0; param < func->paramCount && !in.failed; ++param) {
+				auto type = readType();
+				auto offset = in.Read<uint64_t>();
+				if (!type || offset > func->frameSize || type->Size() > func->frameSize - offset) in.failed = true;
+
+				func->params.push_back(ScriptFunc::Param{ type, offset });
+			}
+
+			if (!returnType || func->frameSize > ExecutionContext::frameStackSize || (func->isMethod && !func->classType)) in.failed = true;
+			loadedFuncs.push_back(std::move(func));
+		}
+		for (auto &type : loadedClasses) {
+			auto methodCount = in.Read<uint32_t>();
+			for (uint32_t i = 0; i < methodCount && !in.failed; ++i) {
+				auto methodName = in.ReadString();
+				auto method = readFunc();
+				if (!method) in.failed = true;
+				else type->AddMethod(methodName, method);
+			}
+		}
+
+		// The globals end with the last object
+		auto loadedGlobalsSize = in.Read<uint64_t>();
+		size_t globalsEnd = 0;
+		auto globalCount = in.Read<uint32_t>();
+		for (uint32_t i = 0; i < globalCount && !in.failed; ++i) {
+			auto objName = in.ReadString();
+			auto type = readType();
+			auto modifiers = in.Read<ScriptObject::Modifier>();
+			if (!type) {
+				in.failed = true;
+				break;
+			}
+
+			auto obj = std::make_unique<ScriptObject>(engine, type, modifiers, false);
+			obj->identifier = objName;
+			obj->module = this;
+			obj->frameOffset = in.Read<uint64_t>();
+			if (obj->frameOffset > loadedGlobalsSize || type->Size() > loadedGlobalsSize - obj->frameOffset) in.failed = true;
+			globalsEnd = std::max(globalsEnd, obj->frameOffset + type->Size());
+
+			visible.push_back(in.Read<bool>());
+			loadedGlobals.push_back(std::move(obj));
+		}
+
+		if (loadedGlobalsSize > globalsEnd) in.failed = true;
+
+		Bytecode loadedCode;
+		readCode(loadedCode);
+		for (size_t i = 0; i < loadedFuncs.size() && !in.failed; ++i) {
+			readCode(*loadedFuncs[i]->code);
+		}
+
+		if (!in.failed && !verify(loadedCode, 0, nullptr, loadedGlobalsSize)) in.failed = true;
+		for (size_t i = 0; i < loadedFuncs.size() && !in.failed; ++i) {
+			auto &func = loadedFuncs[i];
+			if (!verify(*func->code, func->frameSize, func->classType, loadedGlobalsSize)) in.failed = true;
+		}
+
+		if (in.failed || in.pos != in.data.size()) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Invalid compiled module '" << file << "'\n";
+			return RespCode::ERR;
+		}
+
+		// Registered like a linked module, objects in nested blocks are owned by a scope of their own
+		auto hiddenScope = globalScope->AddChild();
+		for (auto &type : loadedClasses) {
+			classes.push_back(type.get());
+			globalScope->RegisterType(type.get());
+			engine->RegisterTypeID(type.release());
+		}
+		for (auto &func : loadedFuncs) {
+			func->Optimize();
+			functions.push_back(func.get());
+			globalScope->RegisterFunc(func.release());
+		}
+		for (size_t i = 0; i < loadedGlobals.size(); ++i) {
+			auto obj = loadedGlobals[i].release();
+			globals.push_back(obj);
+
+			if (!visible[i] || globalScope->RegisterObject(obj) != RespCode::SUCCESS) {
+				hiddenScope->objects.push_back(obj);
+			}
+		}
+		globalsSize = loadedGlobalsSize;
+		moduleCode = std::move(loadedCode);
+
+		CreateOwnContext();
+		return RespCode::SUCCESS;
+	}
+}
@@ -0,0 +1,32 @@
+#include <marklang.h>
+#include <mutex>
+
+namespace mlang {
+	Symbol SymbolTable::Intern(std::string_view name) {
+		{
+			std::shared_lock lock(mutex);
+			if (auto id = ids.find(name); id != ids.end()) {
+				return id->second;
+			}
+		}
+
+		std::unique_lock lock(mutex);
+		if (auto id = ids.find(name); id != ids.end()) {
+			return id->second;
+		}
+
+		auto symbol = static_cast<Symbol>(names.size());
+		ids.emplace(names.emplace_back(name), symbol);
+
+		return symbol;
+	}
+	Response<Symbol> SymbolTable::Find(std::string_view name) const {
+		std::shared_lock lock(mutex);
+		auto id = ids.find(name);
+		if (id == ids.end()) {
+			return Response<Symbol>(RespCode::ERR);
+		}
+
+		return Response<Symbol>(id->second, RespCode::SUCCESS);
+	}
+}
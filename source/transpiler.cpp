@@ -0,0 +1,391 @@
+#include <marklang.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <set>
+
+#if defined(WIN32) || defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <dlfcn.h>
+#endif
+
+#ifndef __FUNCTION_NAME__
+	#if defined(WIN32) || defined(_WIN32)
+	#ifdef __PRETTY_FUNCTION__
+		#define __FUNCTION_NAME__  __PRETTY_FUNCTION__
+	#else
+		#define __FUNCTION_NAME__  __FUNCTION__
+	#endif
+#else
+	#define __FUNCTION_NAME__  __func__
+	#endif
+#endif
+
+namespace mlang {
+	// Bumped whenever the generated code changes, libraries of other versions aren't loaded
+	static constexpr uint32_t transpiledVersion = 3;
+
+	// Operators behave like the kernels: integers wrap around. Integer division by zero and calls past the depth limit set 'failed' to
+	// an AotError, functions return as soon as it's set
+	static const char *prelude = R"(#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#if defined(WIN32) || defined(_WIN32)
+	#define MLANG_EXPORT extern "C" __declspec(dllexport)
+#else
+	#define MLANG_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
+namespace {
+	thread_local int failed = 0;
+	thread_local uint32_t depth = 0;
+
+	// Counts the calls in progress on this thread
+	struct Depth {
+		Depth() { ++depth; }
+		~Depth() { --depth; }
+	};
+
+	template<typename T> using Wide = std::make_unsigned_t<std::common_type_t<T, unsigned int>>;
+
+	template<typename T> inline T Add(T a, T b) {
+		if constexpr (std::is_integral_v<T>) return static_cast<T>(static_cast<Wide<T>>(a) + static_cast<Wide<T>>(b));
+		else return a + b;
+	}
+	template<typename T> inline T Sub(T a, T b) {
+		if constexpr (std::is_integral_v<T>) return static_cast<T>(static_cast<Wide<T>>(a) - static_cast<Wide<T>>(b));
+		else return a - b;
+	}
+	template<typename T> inline T Mul(T a, T b) {
+		if constexpr (std::is_integral_v<T>) return static_cast<T>(static_cast<Wide<T>>(a) * static_cast<Wide<T>>(b));
+		else return a * b;
+	}
+	template<typename T> inline T Div(T a, T b) {
+		if constexpr (std::is_integral_v<T>) {
+			if (b == 0) {
+				failed = divisionByZero;
+				return 0;
+			}
+			// The smallest value divided by -1 wraps around to itself
+			if constexpr (std::is_signed_v<T>) {
+				if (b == -1) return Sub(T(0), a);
+			}
+		}
+		return a / b;
+	}
+	template<typename T> inline T Bits(uint64_t bits) {
+		T value;
+		std::memcpy(&value, &bits, sizeof(T));
+		return value;
+	}
+	template<typename T> inline T Load(const char *src) {
+		T value;
+		std::memcpy(&value, src, sizeof(T));
+		return value;
+	}
+	template<typename T> inline void Store(char *dest, T value) {
+		std::memcpy(dest, &value, sizeof(T));
+	}
+}
+)";
+
+	static const char *CType(NumericKind kind) {
+		switch (kind) {
+			case NumericKind::BOOL: return "bool";
+			case NumericKind::INT8: return "int8_t";
+			case NumericKind::INT16: return "int16_t";
+			case NumericKind::INT32: return "int32_t";
+			case NumericKind::INT64: return "int64_t";
+			case NumericKind::UINT8: return "uint8_t";
+			case NumericKind::UINT16: return "uint16_t";
+			case NumericKind::UINT32: return "uint32_t";
+			case NumericKind::UINT64: return "uint64_t";
+			case NumericKind::FLOAT: return "float";
+			case NumericKind::DOUBLE: return "double";
+			default: break;
+		}
+
+		return "void";
+	}
+
+	// Writes one function, each stack slot and frame offset becomes a variable per kind it holds
+	class FunctionWriter {
+		const OptimizedCode &code;
+		const std::vector<ScriptFunc *> &functions;
+		std::ostringstream body;
+		std::set<std::pair<uint32_t, NumericKind>> slots, locals;
+
+		std::string Slot(uint32_t slot, NumericKind kind) {
+			slots.emplace(slot, kind);
+			return "s" + std::to_string(slot) + "_" + std::to_string(static_cast<int>(kind));
+		}
+		std::string Local(size_t offset, NumericKind kind) {
+			locals.emplace(static_cast<uint32_t>(offset), kind);
+			return "l" + std::to_string(offset) + "_" + std::to_string(static_cast<int>(kind));
+		}
+		std::string Cast(NumericKind to, const std::string &value) {
+			return std::string("static_cast<") + CType(to) + ">(" + value + ")";
+		}
+		// Returns once an operation or a call failed
+		std::string Bail() const {
+			return code.returnType->Size() ? "\tif (failed) return {};\n" : "\tif (failed) return;\n";
+		}
+		size_t Index(const ScriptFunc *func) const {
+			return std::find(functions.begin(), functions.end(), func) - functions.begin();
+		}
+
+		public:
+		FunctionWriter(const OptimizedCode &code_, const std::vector<ScriptFunc *> &functions_) : code(code_), functions(functions_) {}
+
+		// False if an instruction can't be written, 'callable' are the functions it may call
+		bool Write(const std::set<const ScriptFunc *> &callable) {
+			auto &bindings = code.source->bindings;
+			auto supportedBinding = [&](const Binding &binding) {
+				return binding.base == Binding::Base::FRAME || binding.base == Binding::Base::GLOBAL;
+			};
+
+			std::set<uint32_t> targets;
+			for (auto &inst : code.code) {
+				if (inst.op == TypedOp::JUMP || inst.op == TypedOp::LOOP || inst.op == TypedOp::JUMP_IF_FALSE) targets.insert(inst.arg);
+			}
+
+			for (uint32_t i = 0; i < code.code.size(); ++i) {
+				auto &inst = code.code[i];
+				if (targets.contains(i)) body << "L" << i << ":;\n";
+
+				switch (inst.op) {
+					case TypedOp::CONST:
+						body << "\t" << Slot(inst.slot, inst.kind) << " = Bits<" << CType(inst.kind) << ">(" << code.constants[inst.arg] << "ull);\n";
+						break;
+					case TypedOp::LOAD_FRAME:
+						body << "\t" << Slot(inst.slot, inst.kind) << " = " << Local(inst.arg, inst.kind) << ";\n";
+						break;
+					case TypedOp::LOAD: {
+						auto &binding = bindings[inst.arg];
+						if (binding.base != Binding::Base::GLOBAL) return false;
+
+						body << "\t" << Slot(inst.slot, inst.kind) << " = Load<" << CType(inst.kind) << ">(globals + " << binding.offset << ");\n";
+						break;
+					}
+					case TypedOp::STORE_FRAME:
+						body << "\t" << Local(inst.arg, inst.kind) << " = " << Cast(inst.kind, Slot(inst.slot, inst.from)) << ";\n";
+						break;
+					case TypedOp::STORE: {
+						auto &binding = bindings[inst.arg];
+						if (binding.base != Binding::Base::GLOBAL) return false;
+
+						body << "\tStore<" << CType(inst.kind) << ">(globals + " << binding.offset << ", " << Cast(inst.kind, Slot(inst.slot, inst.from)) << ");\n";
+						break;
+					}
+					case TypedOp::ZERO: {
+						auto &binding = bindings[inst.arg];
+						if (!supportedBinding(binding)) return false;
+
+						if (binding.base == Binding::Base::FRAME) body << "\t" << Local(binding.offset, inst.kind) << " = 0;\n";
+						else body << "\tStore<" << CType(inst.kind) << ">(globals + " << binding.offset << ", 0);\n";
+						break;
+					}
+					case TypedOp::COMPUTE: {
+						// Both operands are promoted to the kind arithmetic on them results in
+						NumericKind common;
+						GetKernel(OpCode::ADD, inst.from, inst.fromArg, common);
+
+						auto lhs = Cast(common, Slot(inst.slot, inst.from));
+						auto rhs = Cast(common, Slot(inst.arg, inst.fromArg));
+						auto result = Slot(inst.slot, inst.kind);
+						switch (code.source->code[i].Generic()) {
+							case OpCode::ADD: body << "\t" << result << " = Add(" << lhs << ", " << rhs << ");\n"; break;
+							case OpCode::SUB: body << "\t" << result << " = Sub(" << lhs << ", " << rhs << ");\n"; break;
+							case OpCode::MUL: body << "\t" << result << " = Mul(" << lhs << ", " << rhs << ");\n"; break;
+							case OpCode::DIV: body << "\t" << result << " = Div(" << lhs << ", " << rhs << ");\n" << Bail(); break;
+							case OpCode::LESS: body << "\t" << result << " = " << lhs << " < " << rhs << ";\n"; break;
+							case OpCode::LEQ: body << "\t" << result << " = " << lhs << " <= " << rhs << ";\n"; break;
+							case OpCode::GREATER: body << "\t" << result << " = " << lhs << " > " << rhs << ";\n"; break;
+							case OpCode::GEQ: body << "\t" << result << " = " << lhs << " >= " << rhs << ";\n"; break;
+							case OpCode::EQ: body << "\t" << result << " = " << lhs << " == " << rhs << ";\n"; break;
+							case OpCode::NEQ: body << "\t" << result << " = " << lhs << " != " << rhs << ";\n"; break;
+							default: return false;
+						}
+						break;
+					}
+					case TypedOp::JUMP:
+					case TypedOp::LOOP:
+						body << "\tgoto L" << inst.arg << ";\n";
+						break;
+					case TypedOp::JUMP_IF_FALSE:
+						body << "\tif (!" << Cast(NumericKind::BOOL, Slot(inst.slot, inst.from)) << ") goto L" << inst.arg << ";\n";
+						break;
+					case TypedOp::CALL: {
+						auto &binding = bindings[inst.arg];
+						auto callee = binding.func;
+						if (binding.kind != Binding::Kind::FUNCTION || !callable.contains(callee)) return false;
+
+						std::string call = "f" + std::to_string(Index(callee)) + "(globals";
+						for (uint32_t p = 0; p < inst.arg2; ++p) {
+							call += ", " + Cast(callee->GetParams()[p].type->Kind(), Slot(inst.slot + p, code.argKinds[inst.aux + p]));
+						}
+						call += ")";
+
+						// Void functions leave an int 0 behind
+						if (callee->GetReturnType()->Size()) body << "\t" << Slot(inst.slot, inst.kind) << " = " << call << ";\n";
+						else body << "\t" << call << ";\n\t" << Slot(inst.slot, inst.kind) << " = 0;\n";
+						body << Bail();
+						break;
+					}
+					case TypedOp::RETURN:
+						body << "\treturn " << Cast(inst.kind, Slot(inst.slot, inst.from)) << ";\n";
+						break;
+					case TypedOp::RETURN_VOID:
+						body << "\treturn" << (code.returnType->Size() ? " {}" : "") << ";\n";
+						break;
+					case TypedOp::NOP:
+						break;
+					default:
+						return false;
+				}
+			}
+
+			return true;
+		}
+
+		// Declaration of function 'idx', 'body' once written
+		std::string Signature(size_t idx, const ScriptFunc *func) const {
+			std::string ret = std::string("static ") + CType(func->GetReturnType()->Kind()) + " f" + std::to_string(idx) + "(char *globals";
+			for (size_t p = 0; p < func->GetParams().size(); ++p) {
+				ret += std::string(", ") + CType(func->GetParams()[p].type->Kind()) + " p" + std::to_string(p);
+			}
+			return ret + ")";
+		}
+		std::string Definition(size_t idx, const ScriptFunc *func) const {
+			std::ostringstream out;
+			out << Signature(idx, func) << " {\n";
+
+			// Recursion stops at the interpreter's depth limit instead of overflowing the host's stack
+			out << "\tDepth guard;\n\tif (depth > maxCallDepth) failed = stackOverflow;\n" << Bail();
+
+			// Parameters start in their locals, everything else starts zeroed
+			for (auto &[offset, kind] : locals) {
+				std::string init = "0";
+				for (size_t p = 0; p < func->GetParams().size(); ++p) {
+					if (func->GetParams()[p].offset == offset && func->GetParams()[p].type->Kind() == kind) init = "p" + std::to_string(p);
+				}
+				out << "\t" << CType(kind) << " l" << offset << "_" << static_cast<int>(kind) << " = " << init << ";\n";
+			}
+			for (auto &[slot, kind] : slots) {
+				out << "\t" << CType(kind) << " s" << slot << "_" << static_cast<int>(kind) << " = 0;\n";
+			}
+
+			out << body.str();
+			if (func->GetReturnType()->Size()) out << "\treturn {};\n";
+			out << "}\n";
+			return out.str();
+		}
+	};
+
+	RespCode Module::Transpile(const std::string &file) const {
+		if (!context) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Module '" << name << "' isn't built\n";
+			return RespCode::ERR;
+		}
+
+		// Functions are dropped until every one left only calls the others
+		std::set<const ScriptFunc *> callable;
+		for (auto func : functions) {
+			if (func->optimized && !func->isMethod) callable.insert(func);
+		}
+
+		std::vector<std::unique_ptr<FunctionWriter>> writers;
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			writers.clear();
+			writers.resize(functions.size());
+
+			for (size_t i = 0; i < functions.size(); ++i) {
+				if (!callable.contains(functions[i])) continue;
+
+				writers[i] = std::make_unique<FunctionWriter>(*functions[i]->optimized, functions);
+				if (!writers[i]->Write(callable)) {
+					callable.erase(functions[i]);
+					changed = true;
+				}
+			}
+		}
+
+		std::ofstream out(file, std::ios::binary);
+		if (!out) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Couldn't open '" << file << "'\n";
+			return RespCode::ERR;
+		}
+
+		out << "// Functions of module '" << name << "', generated by mlang::Module::Transpile. Rebuild it whenever the module changes\n";
+		out << "static constexpr int divisionByZero = " << static_cast<int>(AotError::DIVISION_BY_ZERO) << ", stackOverflow = " << static_cast<int>(AotError::STACK_OVERFLOW) << ";\n";
+		out << "static constexpr unsigned maxCallDepth = " << ExecutionContext::maxCallDepth << ";\n";
+		out << prelude << "\n";
+		for (size_t i = 0; i < functions.size(); ++i) {
+			if (callable.contains(functions[i])) out << writers[i]->Signature(i, functions[i]) << ";\n";
+		}
+		for (size_t i = 0; i < functions.size(); ++i) {
+			if (callable.contains(functions[i])) out << "\n" << writers[i]->Definition(i, functions[i]);
+		}
+
+		// Entries read the parameters from the call frame and return the AotError the function failed with. Nothing is thrown across them
+		out << "\nMLANG_EXPORT uint64_t mlang_hash() { return " << (SourceHash() ^ transpiledVersion) << "ull; }\n";
+		for (size_t i = 0; i < functions.size(); ++i) {
+			auto func = functions[i];
+			if (!callable.contains(func)) continue;
+
+			out << "MLANG_EXPORT int mlang_f" << i << "(char *frame, void *ret, char *globals) {\n\tfailed = 0;\n\t";
+			if (func->GetReturnType()->Size()) out << "Store<" << CType(func->GetReturnType()->Kind()) << ">(static_cast<char *>(ret), ";
+			out << "f" << i << "(globals";
+			for (auto &param : func->GetParams()) {
+				out << ", Load<" << CType(param.type->Kind()) << ">(frame + " << param.offset << ")";
+			}
+			out << (func->GetReturnType()->Size() ? "));\n" : ");\n") << "\treturn failed;\n}\n";
+		}
+
+		if (!out) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Couldn't write '" << file << "'\n";
+			return RespCode::ERR;
+		}
+		return RespCode::SUCCESS;
+	}
+
+	RespCode Module::LoadNative(const std::string &library) {
+		if (!context) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Module '" << name << "' isn't built\n";
+			return RespCode::ERR;
+		}
+
+#if defined(WIN32) || defined(_WIN32)
+		auto handle = LoadLibraryA(library.c_str());
+		auto find = [handle](const std::string &symbol) { return reinterpret_cast<void *>(GetProcAddress(handle, symbol.c_str())); };
+		auto lib = std::shared_ptr<void>(handle, [](void *handle) { if (handle) FreeLibrary(static_cast<HMODULE>(handle)); });
+#else
+		auto handle = dlopen(library.c_str(), RTLD_NOW | RTLD_LOCAL);
+		auto find = [handle](const std::string &symbol) { return dlsym(handle, symbol.c_str()); };
+		auto lib = std::shared_ptr<void>(handle, [](void *handle) { if (handle) dlclose(handle); });
+#endif
+		if (!handle) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Couldn't load '" << library << "'\n";
+			return RespCode::ERR;
+		}
+
+		auto hash = reinterpret_cast<uint64_t (*)()>(find("mlang_hash"));
+		if (!hash || hash() != (SourceHash() ^ transpiledVersion)) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " Library '" << library << "' wasn't transpiled from this module\n";
+			return RespCode::ERR;
+		}
+
+		for (size_t i = 0; i < functions.size(); ++i) {
+			if (auto entry = find("mlang_f" + std::to_string(i))) functions[i]->aot = reinterpret_cast<AotFunction>(entry);
+		}
+
+		nativeLibrary = std::move(lib);
+		return RespCode::SUCCESS;
+	}
+}
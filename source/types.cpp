@@ -1,11 +1,14 @@
 #include <marklang.h>
+#include <algorithm>
 
 namespace mlang {
 	TypeInfo::TypeInfo(const TypeInfo *other)
-		:typeID(other->engine->GenerateTID()), name(other->name), typeSz(other->typeID),
-		unsig(other->unsig), engine(other->engine), offset(other->offset), parentClass(other->parentClass),
+		:typeID(0), name(other->name), typeSz(other->typeSz),
+		unsig(other->unsig), kind(other->kind), engine(other->engine), offset(other->offset), parentClass(other->parentClass),
 		isClass(other->isClass), baseClasses(other->baseClasses),
-		methods(other->methods), members(other->members), visibility(other->visibility) {}
+		methods(other->methods), members(other->members), memberIndices(other->memberIndices) {
+		engine->RegisterTypeID(this);
+	}
 	TypeInfo::~TypeInfo() {}
 
 	bool TypeInfo::IsBaseOf(const TypeInfo *base) const {
@@ -22,11 +25,17 @@ namespace mlang {
 		return false;
 	}
 
-	RespCode TypeInfo::AddMember(const std::string &name, TypeInfo *type) {
+	RespCode TypeInfo::AddMember(const std::string &name, TypeInfo *type, Visibility visibility) {
 		if (!type) return RespCode::ERR;
-		if (members.contains(name)) return RespCode::ERR;
+		if (memberIndices.contains(name)) return RespCode::ERR;
+
+		// Natural alignment for primitives, classes are aligned like the largest primitive
+		size_t alignment = (type->IsClass() ? 8 : std::max<size_t>(type->Size(), 1));
+		size_t offset = (typeSz + alignment - 1) / alignment * alignment;
 
-		members[name] = type;
+		memberIndices[name] = members.size();
+		members.push_back(Member{ name, type, offset, visibility });
+		typeSz = offset + type->Size();
 
 		return RespCode::SUCCESS;
 	}
@@ -0,0 +1,527 @@
+#include <marklang.h>
+#include <iostream>
+#include <cstring>
+
+#ifndef __FUNCTION_NAME__
+	#if defined(WIN32) || defined(_WIN32)
+	#ifdef __PRETTY_FUNCTION__
+		#define __FUNCTION_NAME__  __PRETTY_FUNCTION__
+	#else
+		#define __FUNCTION_NAME__  __FUNCTION__
+	#endif
+#else
+	#define __FUNCTION_NAME__  __func__
+	#endif
+#endif
+
+namespace mlang {
+	// Loop iterations are added to the function's count in batches
+	static constexpr uint32_t iterationBatch = 256;
+
+	template<typename Op>
+	static inline void BinaryOp(std::vector<ScriptRval> &stack, Op op) {
+		ScriptRval rhs = std::move(stack.back());
+		stack.pop_back();
+		stack.back() = op(stack.back(), rhs);
+	}
+	static void GenericOp(OpCode op, std::vector<ScriptRval> &stack) {
+		switch (op) {
+			case OpCode::ADD:
+				BinaryOp(stack, [](const ScriptRval &lhs, const ScriptRval &rhs) { return lhs + rhs; });
+				break;
+			case OpCode::SUB:
+				BinaryOp(stack, [](const ScriptRval &lhs, const ScriptRval &rhs) { return lhs - rhs; });
+				break;
+			case OpCode::MUL:
+				BinaryOp(stack, [](const ScriptRval &lhs, const ScriptRval &rhs) { return lhs * rhs; });
+				break;
+			case OpCode::DIV:
+				BinaryOp(stack, [](const ScriptRval &lhs, const ScriptRval &rhs) { return lhs / rhs; });
+				break;
+			case OpCode::LESS:
+				BinaryOp(stack, [](const ScriptRval &lhs, const ScriptRval &rhs) { return lhs < rhs; });
+				break;
+			case OpCode::LEQ:
+				BinaryOp(stack, [](const ScriptRval &lhs, const ScriptRval &rhs) { return lhs <= rhs; });
+				break;
+			case OpCode::GREATER:
+				BinaryOp(stack, [](const ScriptRval &lhs, const ScriptRval &rhs) { return lhs > rhs; });
+				break;
+			case OpCode::GEQ:
+				BinaryOp(stack, [](const ScriptRval &lhs, const ScriptRval &rhs) { return lhs >= rhs; });
+				break;
+			case OpCode::EQ:
+				BinaryOp(stack, [](const ScriptRval &lhs, const ScriptRval &rhs) { return lhs == rhs; });
+				break;
+			case OpCode::NEQ:
+				BinaryOp(stack, [](const ScriptRval &lhs, const ScriptRval &rhs) { return lhs != rhs; });
+				break;
+			default:
+				break;
+		}
+	}
+	// Operator in the low byte, the operands' kinds above
+	static constexpr uint32_t Quickened(OpCode op, NumericKind lhs, NumericKind rhs) {
+		return static_cast<uint32_t>(op) | (static_cast<uint32_t>(lhs) << 8) | (static_cast<uint32_t>(rhs) << 16);
+	}
+
+	ExecutionContext::ExecutionContext(const Module *module_)
+		:module(module_), engine(module_->engine), globals(std::make_unique<char[]>(module_->globalsSize)), frameStack(std::make_unique<char[]>(frameStackSize)) {
+		moduleGlobals = globals.get();
+	}
+
+	RespCode ExecutionContext::Initialize() {
+		std::vector<ScriptRval> stack;
+
+		return Execute(module->moduleCode, stack);
+	}
+	RespCode ExecutionContext::Run() {
+		if (Initialize() != RespCode::SUCCESS) {
+			return RespCode::ERR;
+		}
+
+		auto mainFunc = module->FindFunction("main");
+		if (!mainFunc) {
+			return RespCode::ERR;
+		}
+
+		std::vector<ScriptRval> stack;
+		Invoke(mainFunc, stack, 0);
+
+		return RespCode::SUCCESS;
+	}
+
+	void *ExecutionContext::Address(const Binding &binding) {
+		switch (binding.base) {
+			case Binding::Base::GLOBAL:
+				return moduleGlobals + binding.offset;
+			case Binding::Base::FRAME:
+				return frame + binding.offset;
+			case Binding::Base::THIS:
+				return reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(thisPtr) + binding.offset);
+			case Binding::Base::STATIC:
+				break;
+		}
+
+		return GlobalsOf(binding.module) + binding.offset;
+	}
+	char *ExecutionContext::GlobalsOf(const Module *owner) {
+		if (owner == module) return globals.get();
+
+		auto &copy = imported[owner];
+		if (copy) return copy.get();
+
+		// Added before its code runs, the module may reach itself through another one
+		copy = std::make_unique<char[]>(owner->globalsSize);
+		auto lastGlobals = moduleGlobals;
+		moduleGlobals = copy.get();
+
+		std::vector<ScriptRval> stack;
+		if (Execute(owner->moduleCode, stack) != RespCode::SUCCESS) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Couldn't initialize the objects of module '" << owner->GetName() << "'\n";
+		}
+
+		moduleGlobals = lastGlobals;
+		return copy.get();
+	}
+	char *ExecutionContext::NextFrame(const ScriptFunc *func) const {
+		if (callDepth >= maxCallDepth || frameTop + func->frameSize > frameStackSize) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Stack overflow calling '" << func->GetName() << "'\n";
+			return nullptr;
+		}
+
+		return frameStack.get() + frameTop;
+	}
+	RespCode ExecutionContext::Invoke(ScriptFunc *func, std::vector<ScriptRval> &stack, size_t paramCount, void *object) {
+		if (paramCount != func->paramCount) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " "
+				<< "Function '" << func->GetName() << "' expects " << func->paramCount << " parameters, got " << paramCount << "\n";
+			return RespCode::ERR;
+		}
+
+		// Every call gets its own frame, the callee's locals live there
+		char *callFrame = NextFrame(func);
+		if (!callFrame) return RespCode::ERR;
+
+		// Parameters were pushed in order, the first one is the deepest
+		auto params = stack.end() - paramCount;
+		for (size_t i = 0; i < paramCount; ++i) {
+			auto &param = func->params[i];
+
+			if (ScriptObject::StoreVal(param.type, callFrame + param.offset, params[i]) != RespCode::SUCCESS) {
+				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " "
+					<< "Invalid parameter n" << i + 1 << " to function '" << func->GetName() << "'\n";
+				return RespCode::ERR;
+			}
+		}
+		stack.erase(params, stack.end());
+
+		return Enter(func, stack, object);
+	}
+	RespCode ExecutionContext::Enter(ScriptFunc *func, std::vector<ScriptRval> &stack, void *object) {
+		char *callFrame = frameStack.get() + frameTop;
+
+		auto lastFrame = frame;
+		auto lastThis = thisPtr;
+		auto lastGlobals = moduleGlobals;
+		// Functions of other modules see this context's copy of their objects
+		if (func->module) moduleGlobals = GlobalsOf(func->module);
+		frame = callFrame;
+		frameTop += func->frameSize;
+		thisPtr = object;
+		callDepth++;
+
+		auto retCode = RespCode::SUCCESS;
+		if (func->native) {
+			// The thunk reads the parameters straight from the frame
+			ScriptRval ret{ engine, func->returnType };
+			ret.data = ret.inlineData;
+			func->native(func->nativeTarget.get(), callFrame, ret.data);
+
+			if (func->returnType->Size()) stack.push_back(std::move(ret));
+			else stack.push_back(ScriptRval::Create<int32_t>(engine, engine->GetPrimitive(Engine::Primitive::INT32), 0));
+		}
+		else if (func->aot) {
+			ScriptRval ret{ engine, func->returnType };
+			ret.data = ret.inlineData;
+			auto error = static_cast<AotError>(func->aot(callFrame, ret.data, moduleGlobals));
+			if (error != AotError::NONE) {
+				std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << (error == AotError::STACK_OVERFLOW ? "Stack overflow" : "Division by zero") << " in '" << func->GetName() << "'\n";
+				retCode = RespCode::ERR;
+			}
+			else if (func->returnType->Size()) stack.push_back(std::move(ret));
+			else stack.push_back(ScriptRval::Create<int32_t>(engine, engine->GetPrimitive(Engine::Primitive::INT32), 0));
+		}
+		else {
+			if (auto &optimized = func->optimized) {
+				if (!optimized->jit.load(std::memory_order_relaxed) && func->calls.fetch_add(1, std::memory_order_relaxed) + 1 == ScriptFunc::hotCalls) {
+					func->CompileNative();
+				}
+
+				retCode = ExecuteOptimized(*optimized, stack);
+			}
+			else {
+				retCode = Execute(*func->code, stack);
+			}
+
+			// Primitives are returned as the function's return type
+			auto returnType = func->returnType;
+			if (retCode == RespCode::SUCCESS && returnType->Kind() != NumericKind::NONE && stack.back().valueType != returnType) {
+				ScriptRval ret{ engine, returnType };
+				ret.data = ret.inlineData;
+
+				retCode = ScriptObject::StoreVal(returnType, ret.data, stack.back());
+				stack.back() = std::move(ret);
+			}
+		}
+
+		callDepth--;
+		frameTop -= func->frameSize;
+		frame = lastFrame;
+		thisPtr = lastThis;
+		moduleGlobals = lastGlobals;
+
+		return retCode;
+	}
+
+	RespCode ExecutionContext::Execute(const Bytecode &code, std::vector<ScriptRval> &stack) {
+		const Instruction *begin = code.code.data();
+		const Instruction *ip = begin;
+
+		while (true) {
+			const Instruction &inst = *ip++;
+			auto op = std::atomic_ref<OpCode>(inst.op).load(std::memory_order_acquire);
+
+			switch (op) {
+				case OpCode::PUSH_CONST:
+					stack.push_back(code.constants[inst.arg]);
+					break;
+				case OpCode::LOAD: {
+					auto &binding = code.bindings[inst.arg];
+
+					stack.push_back(ScriptRval::CreateFromMemory(engine, binding.type, Address(binding)));
+					break;
+				}
+				case OpCode::STORE: {
+					auto &binding = code.bindings[inst.arg];
+
+					auto retCode = ScriptObject::StoreVal(binding.type, Address(binding), stack.back());
+					stack.pop_back();
+
+					if (retCode != RespCode::SUCCESS) return RespCode::ERR;
+					break;
+				}
+				case OpCode::DECLARE: {
+					auto &binding = code.bindings[inst.arg];
+					auto addr = Address(binding);
+
+					if (!inst.arg2) {
+						std::memset(addr, 0, binding.type->Size());
+						break;
+					}
+
+					auto retCode = ScriptObject::StoreVal(binding.type, addr, stack.back());
+					stack.pop_back();
+
+					if (retCode != RespCode::SUCCESS) return RespCode::ERR;
+					break;
+				}
+				case OpCode::POP:
+					stack.pop_back();
+					break;
+				case OpCode::FAIL:
+					std::cerr << code.errors[inst.arg];
+					return RespCode::ERR;
+
+				case OpCode::ADD:
+				case OpCode::SUB:
+				case OpCode::MUL:
+				case OpCode::DIV:
+				case OpCode::LESS:
+				case OpCode::LEQ:
+				case OpCode::GREATER:
+				case OpCode::GEQ:
+				case OpCode::EQ:
+				case OpCode::NEQ: {
+					// Other contexts may be running the same code, arg is written before the operation
+					std::atomic_ref<uint32_t> quickened(inst.arg);
+					if (!quickened.load(std::memory_order_relaxed)) {
+						auto lhs = stack[stack.size() - 2].valueType->Kind();
+						auto rhs = stack.back().valueType->Kind();
+
+						// A failed probe still sets arg, the operator stays generic without probing again
+						NumericKind result;
+						quickened.store(Quickened(op, lhs, rhs), std::memory_order_relaxed);
+						if (GetKernel(op, lhs, rhs, result)) {
+							std::atomic_ref<OpCode>(inst.op).store(OpCode::COMPUTE, std::memory_order_release);
+
+							if (Compute(Quickened(op, lhs, rhs), stack)) break;
+						}
+					}
+
+					GenericOp(op, stack);
+					break;
+				}
+				case OpCode::COMPUTE: {
+					auto quickened = std::atomic_ref<uint32_t>(inst.arg).load(std::memory_order_relaxed);
+					if (Compute(quickened, stack)) break;
+
+					// Keeps its arg, the operator won't quicken again
+					auto generic = static_cast<OpCode>(quickened & 0xff);
+					std::atomic_ref<OpCode>(inst.op).store(generic, std::memory_order_release);
+					GenericOp(generic, stack);
+					break;
+				}
+
+				case OpCode::JUMP:
+					ip = begin + inst.arg;
+					break;
+				case OpCode::JUMP_IF_FALSE: {
+					bool cond = static_cast<bool>(stack.back());
+					stack.pop_back();
+
+					if (!cond) ip = begin + inst.arg;
+					break;
+				}
+				case OpCode::CALL: {
+					auto &binding = code.bindings[inst.arg];
+					void *object = (binding.kind == Binding::Kind::METHOD ? Address(binding) : nullptr);
+
+					if (Invoke(binding.func, stack, inst.arg2, object) != RespCode::SUCCESS) return RespCode::ERR;
+					break;
+				}
+				case OpCode::RETURN:
+					// The frame is about to be reused
+					stack.back().Detach();
+					return RespCode::SUCCESS;
+				case OpCode::RETURN_VOID:
+					stack.push_back(ScriptRval::Create<int32_t>(engine, engine->GetPrimitive(Engine::Primitive::INT32), 0));
+					return RespCode::SUCCESS;
+				case OpCode::HALT:
+					return RespCode::SUCCESS;
+			}
+		}
+	}
+
+	bool ExecutionContext::Compute(uint32_t quickened, std::vector<ScriptRval> &stack) const {
+		auto op = static_cast<OpCode>(quickened & 0xff);
+		auto lhsKind = static_cast<NumericKind>((quickened >> 8) & 0xff);
+		auto rhsKind = static_cast<NumericKind>((quickened >> 16) & 0xff);
+
+		// The result replaces the left operand
+		auto &lhs = stack[stack.size() - 2];
+		auto &rhs = stack.back();
+		if (lhs.valueType->Kind() != lhsKind || rhs.valueType->Kind() != rhsKind || !lhs.IsInline()) {
+			return false;
+		}
+
+		NumericKind result;
+		GetKernel(op, lhsKind, rhsKind, result)(lhs.data, rhs.data, lhs.inlineData);
+		lhs.valueType = engine->GetPrimitive(static_cast<Engine::Primitive>(result));
+
+		stack.pop_back();
+		return true;
+	}
+
+	RespCode ExecutionContext::ExecuteOptimized(const OptimizedCode &code, std::vector<ScriptRval> &stack) {
+		// The slots are reserved above the frame, calls get their frames after them
+		auto slotsSize = code.slotCount * sizeof(uint64_t);
+		if (frameTop + slotsSize > frameStackSize) {
+			std::cerr << __FUNCTION_NAME__ << " " << __LINE__ << " " << "Stack overflow\n";
+			return RespCode::ERR;
+		}
+
+		auto slots = reinterpret_cast<uint64_t *>(frameStack.get() + frameTop);
+		frameTop += slotsSize;
+
+		TypedState state{ this, &stack, &code, slots, frame };
+		if (auto jit = code.jit.load(std::memory_order_acquire)) {
+			ExecuteNative(code, *jit, stack, slots, 0);
+		}
+		else {
+			for (auto inst = code.code.data(); inst; inst = inst->handler(state, inst));
+		}
+
+		frameTop -= slotsSize;
+		return state.result;
+	}
+	void ExecutionContext::ExecuteNative(const OptimizedCode &code, const JitCode &jit, std::vector<ScriptRval> &stack, uint64_t *slots, uint32_t start) {
+		ScriptRval ret{ engine, code.returnType };
+		ret.data = ret.inlineData;
+
+		if (jit.Entry(start)(frame, slots, ret.inlineData, moduleGlobals)) stack.push_back(std::move(ret));
+		else stack.push_back(ScriptRval::Create<int32_t>(engine, engine->GetPrimitive(Engine::Primitive::INT32), 0));
+	}
+
+	template<TypedOp Op, size_t Size>
+	const TypedInstruction *ExecutionContext::Step(TypedState &state, const TypedInstruction *inst) {
+		auto context = state.context;
+		auto slot = &state.slots[inst->slot];
+
+		if constexpr (Op == TypedOp::CONST) {
+			*slot = state.code->constants[inst->arg];
+		}
+		else if constexpr (Op == TypedOp::LOAD_FRAME) {
+			std::memcpy(slot, state.frame + inst->arg, Size);
+		}
+		else if constexpr (Op == TypedOp::LOAD) {
+			std::memcpy(slot, context->Address(state.code->source->bindings[inst->arg]), Size);
+		}
+		else if constexpr (Op == TypedOp::STORE_FRAME || Op == TypedOp::STORE) {
+			void *dest;
+			if constexpr (Op == TypedOp::STORE_FRAME) dest = state.frame + inst->arg;
+			else dest = context->Address(state.code->source->bindings[inst->arg]);
+
+			if constexpr (Size) std::memcpy(dest, slot, Size);
+			else inst->convert(slot, dest);
+		}
+		else if constexpr (Op == TypedOp::ZERO) {
+			std::memset(context->Address(state.code->source->bindings[inst->arg]), 0, inst->size);
+		}
+		else if constexpr (Op == TypedOp::COMPUTE) {
+			inst->kernel(slot, &state.slots[inst->arg], slot);
+		}
+		else if constexpr (Op == TypedOp::JUMP) {
+			return inst->target;
+		}
+		else if constexpr (Op == TypedOp::LOOP) {
+			if (++state.iterations < iterationBatch) return inst->target;
+			state.iterations = 0;
+
+			auto func = state.code->func;
+			auto total = func->iterations.fetch_add(iterationBatch, std::memory_order_relaxed) + iterationBatch;
+			if (total >= ScriptFunc::hotIterations && total - iterationBatch < ScriptFunc::hotIterations) func->CompileNative();
+
+			// The machine code continues from the loop's head
+			auto jit = state.code->jit.load(std::memory_order_acquire);
+			if (!jit) return inst->target;
+
+			context->ExecuteNative(*state.code, *jit, *state.stack, state.slots, inst->arg);
+			return nullptr;
+		}
+		else if constexpr (Op == TypedOp::JUMP_IF_FALSE) {
+			bool cond;
+			if constexpr (Size) cond = *reinterpret_cast<const bool *>(slot);
+			else inst->convert(slot, &cond);
+
+			if (!cond) return inst->target;
+		}
+		else if constexpr (Op == TypedOp::CALL) {
+			auto &binding = state.code->source->bindings[inst->arg];
+			auto func = binding.func;
+
+			// Parameters are converted straight into the callee's frame
+			char *callFrame = context->NextFrame(func);
+			if (!callFrame) {
+				state.result = RespCode::ERR;
+				return nullptr;
+			}
+
+			for (uint32_t i = 0; i < inst->arg2; ++i) {
+				state.code->conversions[inst->aux + i](slot + i, callFrame + func->params[i].offset);
+			}
+
+			void *object = (binding.kind == Binding::Kind::METHOD ? context->Address(binding) : nullptr);
+			if (context->Enter(func, *state.stack, object) != RespCode::SUCCESS) {
+				state.result = RespCode::ERR;
+				return nullptr;
+			}
+
+			std::memcpy(slot, state.stack->back().data, inst->size);
+			state.stack->pop_back();
+		}
+		else if constexpr (Op == TypedOp::RETURN) {
+			ScriptRval ret{ context->engine, state.code->returnType };
+			ret.data = ret.inlineData;
+			inst->convert(slot, ret.inlineData);
+
+			state.stack->push_back(std::move(ret));
+			return nullptr;
+		}
+		else if constexpr (Op == TypedOp::RETURN_VOID) {
+			state.stack->push_back(ScriptRval::Create<int32_t>(context->engine, context->engine->GetPrimitive(Engine::Primitive::INT32), 0));
+			return nullptr;
+		}
+		else if constexpr (Op == TypedOp::FAIL) {
+			std::cerr << state.code->source->errors[inst->arg];
+			state.result = RespCode::ERR;
+			return nullptr;
+		}
+
+		return inst + 1;
+	}
+	template<TypedOp Op>
+	TypedHandler ExecutionContext::Sized(size_t size) {
+		switch (size) {
+			case 1: return &Step<Op, 1>;
+			case 2: return &Step<Op, 2>;
+			case 4: return &Step<Op, 4>;
+			case 8: return &Step<Op, 8>;
+		}
+
+		return &Step<Op, 0>;
+	}
+	TypedHandler ExecutionContext::HandlerFor(const TypedInstruction &inst) {
+		switch (inst.op) {
+			case TypedOp::CONST: return &Step<TypedOp::CONST>;
+			case TypedOp::LOAD_FRAME: return Sized<TypedOp::LOAD_FRAME>(inst.size);
+			case TypedOp::LOAD: return Sized<TypedOp::LOAD>(inst.size);
+			// Values of the same kind are copied
+			case TypedOp::STORE_FRAME: return Sized<TypedOp::STORE_FRAME>(inst.from == inst.kind ? inst.size : 0);
+			case TypedOp::STORE: return Sized<TypedOp::STORE>(inst.from == inst.kind ? inst.size : 0);
+			case TypedOp::ZERO: return &Step<TypedOp::ZERO>;
+			case TypedOp::COMPUTE: return &Step<TypedOp::COMPUTE>;
+			case TypedOp::JUMP: return &Step<TypedOp::JUMP>;
+			case TypedOp::LOOP: return &Step<TypedOp::LOOP>;
+			case TypedOp::JUMP_IF_FALSE: return (inst.from == NumericKind::BOOL ? &Step<TypedOp::JUMP_IF_FALSE, 1> : &Step<TypedOp::JUMP_IF_FALSE>);
+			case TypedOp::CALL: return &Step<TypedOp::CALL>;
+			case TypedOp::RETURN: return &Step<TypedOp::RETURN>;
+			case TypedOp::RETURN_VOID: return &Step<TypedOp::RETURN_VOID>;
+			case TypedOp::FAIL: return &Step<TypedOp::FAIL>;
+			case TypedOp::NOP: return &Step<TypedOp::NOP>;
+			default: break;
+		}
+
+		return &Step<TypedOp::NOP>;
+	}
+}